@@ -0,0 +1,407 @@
+#include "header.h"
+
+// Command line with NULs turned into spaces, "" for kernel threads
+static string readCommandLine(int pid) {
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/cmdline", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return "";
+    char buffer[4096];
+    ssize_t len = read(fd, buffer, sizeof(buffer));
+    close(fd);
+    if (len <= 0) return "";
+    while (len > 0 && buffer[len - 1] == '\0') len--;
+    replace(buffer, buffer + len, '\0', ' ');
+    return string(buffer, len);
+}
+
+// cgroup v2 path relative to the hierarchy root, from /proc/[pid]/cgroup
+static string readCgroupPath(int pid) {
+    ifstream file("/proc/" + to_string(pid) + "/cgroup");
+    string line;
+    while (getline(file, line)) {
+        if (line.compare(0, 3, "0::") == 0) return line.substr(3);
+    }
+    return "";
+}
+
+ProcessAlertEngine::ProcessAlertEngine()
+    : rules_revision(0), needs_cmdline(false), needs_cgroup(false), log_file(nullptr),
+      generation(0), dropped(0) {}
+
+ProcessAlertEngine::~ProcessAlertEngine() {
+    if (log_file) fclose(log_file);
+}
+
+const char* ProcessAlertEngine::metricName(AlertMetric metric) {
+    switch (metric) {
+        case ALERT_METRIC_CPU: return "CPU%";
+        case ALERT_METRIC_MEMORY: return "Memory%";
+        default: return "?";
+    }
+}
+
+// Compile every pattern up front; a bad one rejects the whole set
+bool ProcessAlertEngine::setRules(const vector<ProcessAlertRule>& rules, string& error) {
+    vector<CompiledRule> next;
+    bool cmdline = false, cgroup = false;
+    for (const auto& rule : rules) {
+        try {
+            next.push_back({rule, regex(rule.pattern, regex::icase | regex::optimize)});
+        } catch (const regex_error& e) {
+            error = "bad pattern '" + rule.pattern + "': " + e.what();
+            return false;
+        }
+        cmdline |= rule.field == ALERT_MATCH_CMDLINE;
+        cgroup |= rule.field == ALERT_MATCH_CGROUP;
+    }
+    
+    lock_guard<mutex> guard(lock);
+    compiled.swap(next);
+    for (auto& cache : subject_matches) cache.clear();
+    needs_cmdline = cmdline;
+    needs_cgroup = cgroup;
+    rules_revision++;
+    error.clear();
+    return true;
+}
+
+bool ProcessAlertEngine::setLogFile(const string& path, string& error) {
+    FILE* file = nullptr;
+    if (!path.empty()) {
+        file = fopen(path.c_str(), "a");
+        if (!file) {
+            error = path + ": " + strerror(errno);
+            return false;
+        }
+    }
+    lock_guard<mutex> guard(lock);
+    if (log_file) fclose(log_file);
+    log_file = file;
+    error.clear();
+    return true;
+}
+
+bool ProcessAlertEngine::pollEvent(AlertEvent& event) {
+    return events.pop(event);
+}
+
+// Called with the lock held
+void ProcessAlertEngine::emit(const AlertEvent& event) {
+    if (!events.push(event)) dropped++;
+    
+    if (log_file) {
+        char stamp[32];
+        struct tm local;
+        localtime_r(&event.time, &local);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+        const ProcessAlertRule* rule = nullptr;
+        for (const auto& candidate : compiled) {
+            if (candidate.rule.id == event.rule_id) rule = &candidate.rule;
+        }
+        fprintf(log_file, "%s %s rule=%d pid=%d name=%s %s=%.1f\n", stamp, event.raised ? "RAISED" : "CLEARED",
+                event.rule_id, event.pid, event.process_name.c_str(),
+                rule ? metricName(rule->metric) : "value", event.value);
+    }
+}
+
+// Decide which rules apply to a newly seen process instance, keeping the
+// state of rules it already matched
+void ProcessAlertEngine::matchRules(int pid, Tracked& entry) {
+    string cmdline = needs_cmdline ? readCommandLine(pid) : "";
+    string cgroup = needs_cgroup ? readCgroupPath(pid) : "";
+    
+    const string* subjects[3] = {&entry.name, &cmdline, &cgroup};
+    vector<int> matching;
+    for (int field = ALERT_MATCH_NAME; field <= ALERT_MATCH_CGROUP; field++) {
+        const string& subject = *subjects[field];
+        if (subject.empty()) continue;
+        auto& cache = subject_matches[field];
+        auto cached = cache.find(subject);
+        if (cached == cache.end()) {
+            if (cache.size() >= 65536) cache.clear();
+            vector<int> hits;
+            for (size_t i = 0; i < compiled.size(); i++) {
+                if (compiled[i].rule.field == field && regex_search(subject, compiled[i].pattern)) hits.push_back((int)i);
+            }
+            cached = cache.emplace(subject, move(hits)).first;
+        }
+        matching.insert(matching.end(), cached->second.begin(), cached->second.end());
+    }
+    sort(matching.begin(), matching.end());
+    
+    vector<RuleState> previous;
+    previous.swap(entry.matches);
+    for (int i : matching) {
+        const CompiledRule& candidate = compiled[i];
+        RuleState state = {i, candidate.rule.id, false, false, chrono::steady_clock::time_point(), 0.0f};
+        for (auto& old : previous) {
+            if (old.rule_id == candidate.rule.id) {
+                state = old;
+                state.rule = (int)i;
+                old.rule_id = -1;     // Carried over
+            }
+        }
+        entry.matches.push_back(state);
+    }
+    
+    // Rules removed or no longer matching close their alerts
+    for (const auto& old : previous) {
+        if (old.rule_id != -1 && old.active) {
+            emit({time(nullptr), old.rule_id, pid, entry.name, false, old.value});
+        }
+    }
+    entry.rules_revision = rules_revision;
+}
+
+void ProcessAlertEngine::evaluate(const ProcessSnapshot& snapshot) {
+    lock_guard<mutex> guard(lock);
+    if (compiled.empty() && index.empty()) return;
+    
+    generation++;
+    auto now = chrono::steady_clock::now();
+    time_t wall = time(nullptr);
+    
+    for (const auto& proc : snapshot.processes) {
+        auto found = index.find(proc.pid);
+        if (found != index.end() && found->second.start_time != proc.start_time) {
+            // Reused pid: the old process is gone
+            for (const auto& state : found->second.matches) {
+                if (state.active) emit({wall, state.rule_id, proc.pid, found->second.name, false, 0.0f});
+            }
+            index.erase(found);
+            found = index.end();
+        }
+        if (found == index.end()) {
+            if (compiled.empty()) continue;
+            Tracked entry;
+            entry.start_time = proc.start_time;
+            entry.name = proc.name;
+            entry.rules_revision = 0;
+            found = index.emplace(proc.pid, move(entry)).first;
+        }
+        
+        Tracked& entry = found->second;
+        entry.seen = generation;
+        if (entry.rules_revision != rules_revision || entry.name != proc.name) {
+            entry.name = proc.name;   // exec() changes the name
+            matchRules(proc.pid, entry);
+        }
+        
+        for (auto& state : entry.matches) {
+            const ProcessAlertRule& rule = compiled[state.rule].rule;
+            float value = rule.metric == ALERT_METRIC_CPU ? proc.cpu_usage : proc.memory_usage;
+            state.value = value;
+            if (!state.active) {
+                if (value > rule.raise_threshold) {
+                    if (!state.above) {
+                        state.above = true;
+                        state.above_since = now;
+                    }
+                    if (chrono::duration<float>(now - state.above_since).count() >= rule.sustain_seconds) {
+                        state.active = true;
+                        emit({wall, rule.id, proc.pid, proc.name, true, value});
+                    }
+                } else {
+                    state.above = false;
+                }
+            } else if (value <= rule.clear_threshold) {
+                state.active = false;
+                state.above = false;
+                emit({wall, rule.id, proc.pid, proc.name, false, value});
+            }
+        }
+    }
+    
+    // Processes that exited
+    for (auto it = index.begin(); it != index.end(); ) {
+        if (it->second.seen == generation) {
+            ++it;
+            continue;
+        }
+        for (const auto& state : it->second.matches) {
+            if (state.active) emit({wall, state.rule_id, it->first, it->second.name, false, 0.0f});
+        }
+        it = index.erase(it);
+    }
+    if (log_file) fflush(log_file);
+}
+
+const char* getMetricAggregateName(MetricAggregate aggregate) {
+    switch (aggregate) {
+        case METRIC_AGGREGATE_LAST: return "last";
+        case METRIC_AGGREGATE_AVG: return "avg";
+        case METRIC_AGGREGATE_MIN: return "min";
+        case METRIC_AGGREGATE_MAX: return "max";
+        case METRIC_AGGREGATE_RATE: return "rate";
+        default: return "?";
+    }
+}
+
+bool parseMetricRule(const string& text, MetricAlertRule& rule, string& error) {
+    static const regex call("^\\s*(avg|min|max|rate|last)\\s*\\(\\s*([^,\\s()]+)\\s*(?:,\\s*([0-9]*\\.?[0-9]+)\\s*(s|m|h)?\\s*)?\\)"
+                            "\\s*([<>])\\s*(\\S+)\\s*(?:clear\\s+(\\S+))?\\s*$");
+    static const regex bare("^\\s*([^\\s()<>]+)\\s*([<>])\\s*(\\S+)\\s*(?:clear\\s+(\\S+))?\\s*$");
+    
+    smatch match;
+    string threshold, clear;
+    if (regex_match(text, match, call)) {
+        const string aggregate = match[1];
+        rule.aggregate = aggregate == "avg" ? METRIC_AGGREGATE_AVG :
+                         aggregate == "min" ? METRIC_AGGREGATE_MIN :
+                         aggregate == "max" ? METRIC_AGGREGATE_MAX :
+                         aggregate == "rate" ? METRIC_AGGREGATE_RATE : METRIC_AGGREGATE_LAST;
+        rule.series = match[2];
+        rule.window_seconds = match[3].matched ? stod(match[3]) : 0.0;
+        if (match[4] == "m") rule.window_seconds *= 60.0;
+        else if (match[4] == "h") rule.window_seconds *= 3600.0;
+        rule.above = match[5] == ">";
+        threshold = match[6];
+        clear = match[7];
+    } else if (regex_match(text, match, bare)) {
+        rule.aggregate = METRIC_AGGREGATE_LAST;
+        rule.series = match[1];
+        rule.window_seconds = 0.0;
+        rule.above = match[2] == ">";
+        threshold = match[3];
+        clear = match[4];
+    } else {
+        error = "expected e.g. \"avg(cpu.usage, 30s) > 90\"";
+        return false;
+    }
+    
+    if (rule.aggregate != METRIC_AGGREGATE_LAST && rule.window_seconds <= 0.0) {
+        error = string(getMetricAggregateName(rule.aggregate)) + "() needs a window, e.g. 30s";
+        return false;
+    }
+    char* end = nullptr;
+    rule.threshold = strtod(threshold.c_str(), &end);
+    if (threshold.empty() || *end) {
+        error = "bad threshold '" + threshold + "'";
+        return false;
+    }
+    rule.clear_threshold = rule.threshold;
+    if (!clear.empty()) {
+        rule.clear_threshold = strtod(clear.c_str(), &end);
+        if (*end) {
+            error = "bad clear threshold '" + clear + "'";
+            return false;
+        }
+    }
+    rule.text = text;
+    return true;
+}
+
+// '*' matches any run of characters, everything else literally
+static bool seriesMatches(const char* pattern, const char* name) {
+    if (*pattern == '\0') return *name == '\0';
+    if (*pattern == '*') {
+        for (const char* rest = name; ; rest++) {
+            if (seriesMatches(pattern + 1, rest)) return true;
+            if (*rest == '\0') return false;
+        }
+    }
+    return *pattern == *name && seriesMatches(pattern + 1, name + 1);
+}
+
+MetricRuleEngine::MetricRuleEngine() : revision(0), bound_revision(0), dropped(0) {}
+
+void MetricRuleEngine::setRules(const vector<MetricAlertRule>& rules) {
+    lock_guard<mutex> guard(lock);
+    pending = rules;
+    revision++;
+}
+
+bool MetricRuleEngine::pollEvent(MetricAlertEvent& event) {
+    return events.pop(event);
+}
+
+void MetricRuleEngine::emit(const MetricAlertEvent& event) {
+    if (!events.push(event)) dropped++;
+}
+
+// Attach rules to the series they match, carrying windows and alert state
+// over for (rule, series) pairs that survive. Instances that go away
+// close their alerts.
+void MetricRuleEngine::bind(const SystemSample& sample) {
+    {
+        lock_guard<mutex> guard(lock);
+        if (bound_revision != revision) {
+            vector<BoundRule> next;
+            for (const auto& rule : pending) {
+                BoundRule entry = {rule, {}};
+                for (auto& old : bound) {
+                    if (old.rule.id == rule.id && old.rule.text == rule.text) entry.instances.swap(old.instances);
+                }
+                next.push_back(move(entry));
+            }
+            for (const auto& old : bound) {
+                for (const auto& instance : old.instances) {
+                    if (instance.active) emit({time(nullptr), old.rule.id, instance.series, false, instance.value});
+                }
+            }
+            bound.swap(next);
+            bound_revision = revision;
+            bound_names.reset();
+        }
+    }
+    if (bound_names == sample.names) return;
+    
+    const vector<string>& names = *sample.names;
+    for (auto& entry : bound) {
+        vector<Instance> previous;
+        previous.swap(entry.instances);
+        for (size_t i = 0; i < names.size(); i++) {
+            if (!seriesMatches(entry.rule.series.c_str(), names[i].c_str())) continue;
+            Instance instance;
+            instance.series = names[i];
+            instance.active = false;
+            instance.value = 0.0;
+            instance.window.setLength(entry.rule.window_seconds);
+            for (auto& old : previous) {
+                if (old.index >= 0 && old.series == names[i]) {
+                    instance = move(old);
+                    old.index = -1;   // Carried over
+                }
+            }
+            instance.index = (int)i;
+            entry.instances.push_back(move(instance));
+        }
+        for (const auto& old : previous) {
+            if (old.index >= 0 && old.active) emit({time(nullptr), entry.rule.id, old.series, false, old.value});
+        }
+    }
+    bound_names = sample.names;
+}
+
+void MetricRuleEngine::evaluate(const SystemSample& sample) {
+    bind(sample);
+    
+    for (auto& entry : bound) {
+        const MetricAlertRule& rule = entry.rule;
+        for (auto& instance : entry.instances) {
+            SlidingWindow& window = instance.window;
+            window.push(sample.time, sample.values[instance.index]);
+            switch (rule.aggregate) {
+                case METRIC_AGGREGATE_AVG: instance.value = window.mean(); break;
+                case METRIC_AGGREGATE_MIN: instance.value = window.minimum(); break;
+                case METRIC_AGGREGATE_MAX: instance.value = window.maximum(); break;
+                case METRIC_AGGREGATE_RATE: instance.value = window.rate(); break;
+                default: instance.value = window.last(); break;
+            }
+            
+            // Judge only complete windows, so a restart does not alert on
+            // the first few samples
+            if (!window.full()) continue;
+            bool past_raise = rule.above ? instance.value > rule.threshold : instance.value < rule.threshold;
+            bool past_clear = rule.above ? instance.value > rule.clear_threshold : instance.value < rule.clear_threshold;
+            if (!instance.active && past_raise) {
+                instance.active = true;
+                emit({time(nullptr), rule.id, instance.series, true, instance.value});
+            } else if (instance.active && !past_clear) {
+                instance.active = false;
+                emit({time(nullptr), rule.id, instance.series, false, instance.value});
+            }
+        }
+    }
+}
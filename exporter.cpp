@@ -0,0 +1,385 @@
+#include "header.h"
+
+static const char* METRICS_CONTENT_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+static void appendValue(string& out, double value) {
+    char buffer[32];
+    out.append(buffer, formatMetricValue(buffer, buffer + sizeof(buffer), value) - buffer);
+}
+
+// Metric names allow [a-zA-Z0-9_:]; interface names may hold '-' or '.'
+static string metricName(const string& name) {
+    string out = "sysmon_" + name;
+    for (char& c : out) {
+        if (!isalnum((unsigned char)c) && c != '_' && c != ':') c = '_';
+    }
+    return out;
+}
+
+static string labelValue(const string& value) {
+    string out;
+    for (char c : value) {
+        if (c == '\\' || c == '"') out += '\\';
+        if (c == '\n') {
+            out += "\\n";
+            continue;
+        }
+        out += c;
+    }
+    return out;
+}
+
+MetricsExporter::MetricsExporter()
+    : system(nullptr), processes(nullptr), listen_fd(-1), epoll_fd(-1), wake_fd(-1), sending_count(0),
+      system_generation(0), process_generation(0), running(false), scrapes(0) {}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start(const string& address, int port, const SystemSampler* system_sampler,
+                            const ProcessTable* process_table, string& error) {
+    if (running) return true;
+    system = system_sampler;
+    processes = process_table;
+    
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        error = "bad listen address '" + address + "'";
+        return false;
+    }
+    
+    listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd == -1) {
+        error = string("socket: ") + strerror(errno);
+        return false;
+    }
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) == -1 || listen(listen_fd, 16) == -1) {
+        error = address + ":" + to_string(port) + ": " + strerror(errno);
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd == -1 || wake_fd == -1) {
+        error = string("epoll: ") + strerror(errno);
+        if (epoll_fd != -1) close(epoll_fd);
+        if (wake_fd != -1) close(wake_fd);
+        close(listen_fd);
+        listen_fd = epoll_fd = wake_fd = -1;
+        return false;
+    }
+    
+    // Slots 0..MAX_CONNECTIONS-1 are connections; the two after are the
+    // listen socket and the wake eventfd
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u32 = MAX_CONNECTIONS;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    event.data.u32 = MAX_CONNECTIONS + 1;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+    
+    connections.assign(MAX_CONNECTIONS, Connection());
+    for (auto& connection : connections) connection.fd = -1;
+    body.reserve(64 * 1024);
+    
+    running = true;
+    worker = thread(&MetricsExporter::run, this);
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!running) return;
+    running = false;
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {}
+    if (worker.joinable()) {
+        worker.join();
+    }
+    for (auto& connection : connections) {
+        if (connection.fd != -1) closeConnection(connection);
+    }
+    close(listen_fd);
+    close(epoll_fd);
+    close(wake_fd);
+    listen_fd = epoll_fd = wake_fd = -1;
+}
+
+void MetricsExporter::run() {
+    epoll_event ready[16];
+    while (running) {
+        int count = epoll_wait(epoll_fd, ready, 16, 1000);
+        if (count < 0 && errno != EINTR) break;
+    
+        for (int i = 0; i < count; i++) {
+            uint32_t slot = ready[i].data.u32;
+            if (slot == MAX_CONNECTIONS) {
+                acceptConnections();
+                continue;
+            }
+            if (slot > MAX_CONNECTIONS) continue;   // Woken by stop()
+    
+            Connection& connection = connections[slot];
+            if (connection.fd == -1) continue;
+            if (ready[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(connection);
+            } else if (connection.sending) {
+                writeResponse(connection);
+            } else {
+                readRequest(connection);
+            }
+        }
+    
+        // Drop connections that went quiet
+        auto now = chrono::steady_clock::now();
+        for (auto& connection : connections) {
+            if (connection.fd != -1 && chrono::duration<float>(now - connection.last_active).count() > IDLE_TIMEOUT) {
+                closeConnection(connection);
+            }
+        }
+    }
+}
+
+void MetricsExporter::acceptConnections() {
+    while (true) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) return;
+    
+        Connection* free_slot = nullptr;
+        for (auto& connection : connections) {
+            if (connection.fd == -1) {
+                free_slot = &connection;
+                break;
+            }
+        }
+        if (!free_slot) {
+            close(fd);
+            continue;
+        }
+    
+        free_slot->fd = fd;
+        free_slot->request_len = 0;
+        free_slot->sending = false;
+        free_slot->last_active = chrono::steady_clock::now();
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u32 = (uint32_t)(free_slot - connections.data());
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void MetricsExporter::closeConnection(Connection& connection) {
+    if (connection.sending) sending_count--;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection.fd, nullptr);
+    close(connection.fd);
+    connection.fd = -1;
+    connection.sending = false;
+}
+
+void MetricsExporter::readRequest(Connection& connection) {
+    while (true) {
+        size_t space = sizeof(connection.request) - 1 - connection.request_len;
+        if (space == 0) {
+            closeConnection(connection);   // Headers too large for a scrape
+            return;
+        }
+        ssize_t len = read(connection.fd, connection.request + connection.request_len, space);
+        if (len == 0) {
+            closeConnection(connection);
+            return;
+        }
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            closeConnection(connection);
+            return;
+        }
+        connection.request_len += len;
+    }
+    connection.request[connection.request_len] = '\0';
+    connection.last_active = chrono::steady_clock::now();
+    if (strstr(connection.request, "\r\n\r\n")) respond(connection);
+}
+
+void MetricsExporter::respond(Connection& connection) {
+    const char* request = connection.request;
+    bool get = strncmp(request, "GET ", 4) == 0;
+    bool head = strncmp(request, "HEAD ", 5) == 0;
+    const char* path = request + (head ? 5 : 4);
+    bool metrics_path = strncmp(path, "/metrics", 8) == 0 && (path[8] == ' ' || path[8] == '?');
+    
+    // HTTP/1.1 keeps the connection unless asked not to
+    const char* line_end = strstr(request, "\r\n");
+    bool http11 = line_end && line_end - request >= 8 && strncmp(line_end - 8, "HTTP/1.1", 8) == 0;
+    bool close_requested = strcasestr(request, "\r\nConnection: close") != nullptr;
+    connection.keep_alive = http11 && !close_requested;
+    
+    const char* status;
+    connection.metrics = false;
+    connection.status_body = "";
+    if (!get && !head) {
+        status = "405 Method Not Allowed";
+        connection.status_body = "only GET is supported\n";
+    } else if (!metrics_path) {
+        status = "404 Not Found";
+        connection.status_body = "metrics are served at /metrics\n";
+    } else {
+        status = "200 OK";
+        connection.metrics = !head;
+        // The body is shared by every connection, so it is only replaced
+        // while nobody is part way through sending it
+        if (sending_count == 0) render();
+        scrapes++;
+    }
+    
+    size_t length = metrics_path && (get || head) ? body.size() : strlen(connection.status_body);
+    int header_len = snprintf(connection.header, sizeof(connection.header),
+                              "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%s\r\n",
+                              status, metrics_path ? METRICS_CONTENT_TYPE : "text/plain; charset=utf-8", length,
+                              connection.keep_alive ? "" : "Connection: close\r\n");
+    connection.header_len = min((size_t)header_len, sizeof(connection.header) - 1);
+    connection.sent = 0;
+    connection.sending = true;
+    sending_count++;
+    writeResponse(connection);
+}
+
+void MetricsExporter::writeResponse(Connection& connection) {
+    const char* payload = connection.metrics ? body.data() : connection.status_body;
+    size_t payload_len = connection.metrics ? body.size() : strlen(connection.status_body);
+    size_t total = connection.header_len + payload_len;
+    
+    while (connection.sent < total) {
+        iovec parts[2];
+        int count = 0;
+        if (connection.sent < connection.header_len) {
+            parts[count].iov_base = connection.header + connection.sent;
+            parts[count].iov_len = connection.header_len - connection.sent;
+            count++;
+        }
+        size_t payload_sent = connection.sent > connection.header_len ? connection.sent - connection.header_len : 0;
+        if (payload_len > payload_sent) {
+            parts[count].iov_base = (void*)(payload + payload_sent);
+            parts[count].iov_len = payload_len - payload_sent;
+            count++;
+        }
+        ssize_t len = writev(connection.fd, parts, count);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                epoll_event event;
+                event.events = EPOLLOUT;
+                event.data.u32 = (uint32_t)(&connection - connections.data());
+                epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.fd, &event);
+                return;
+            }
+            closeConnection(connection);
+            return;
+        }
+        connection.sent += len;
+        connection.last_active = chrono::steady_clock::now();
+    }
+    
+    connection.sending = false;
+    sending_count--;
+    if (!connection.keep_alive) {
+        closeConnection(connection);
+        return;
+    }
+    connection.request_len = 0;
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u32 = (uint32_t)(&connection - connections.data());
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+// Group the system series into metric families. "group.instance.field"
+// series of per-core, per-device and per-interface groups become one
+// family per field with the instance as a label; everything else maps to
+// its own family. Families ending in _total are counters.
+void MetricsExporter::layout(const vector<string>& names) {
+    // Group -> (family prefix, label name)
+    static const map<string, pair<string, string>> INSTANCE_LABELS = {
+        {"cpu", {"cpu_core", "core"}},
+        {"disk", {"disk", "device"}},
+        {"net", {"network", "interface"}},
+        {"psi", {"pressure", "resource"}},
+    };
+    
+    vector<string> families;
+    map<string, vector<pair<int, string>>> members;   // Family -> (series, label)
+    for (size_t i = 0; i < names.size(); i++) {
+        const string& name = names[i];
+        size_t first = name.find('.');
+        size_t last = name.rfind('.');
+        string family, label;
+        auto group = first != last ? INSTANCE_LABELS.find(name.substr(0, first)) : INSTANCE_LABELS.end();
+        if (group != INSTANCE_LABELS.end()) {
+            family = metricName(group->second.first + "_" + name.substr(last + 1));
+            label = "{" + group->second.second + "=\"" + labelValue(name.substr(first + 1, last - first - 1)) + "\"}";
+        } else {
+            family = metricName(name);
+        }
+        if (members.find(family) == members.end()) families.push_back(family);
+        members[family].push_back({(int)i, label});
+    }
+    
+    layout_entries.clear();
+    for (const auto& family : families) {
+        bool counter = family.size() > 6 && family.compare(family.size() - 6, 6, "_total") == 0;
+        string base = counter ? family.substr(0, family.size() - 6) : family;
+        layout_entries.push_back({"# TYPE " + base + (counter ? " counter\n" : " gauge\n"), -1});
+        for (const auto& member : members[family]) {
+            layout_entries.push_back({family + member.second + " ", member.first});
+        }
+    }
+}
+
+// Refresh the body if a sampler published since the last render
+void MetricsExporter::render() {
+    shared_ptr<const SystemSample> sample = system ? system->latest() : nullptr;
+    shared_ptr<const ProcessSnapshot> snapshot = processes ? processes->snapshot() : nullptr;
+    unsigned long next_system = sample ? sample->generation : 0;
+    unsigned long next_process = snapshot ? snapshot->generation : 0;
+    if (!body.empty() && next_system == system_generation && next_process == process_generation) return;
+    system_generation = next_system;
+    process_generation = next_process;
+    
+    body.clear();
+    if (sample && sample->names) {
+        if (layout_names != sample->names) {
+            layout(*sample->names);
+            layout_names = sample->names;
+        }
+        for (const auto& entry : layout_entries) {
+            body += entry.text;
+            if (entry.index < 0) continue;
+            appendValue(body, sample->values[entry.index]);
+            body += '\n';
+        }
+    }
+    
+    // Generation 0 is the empty placeholder (no sample yet, or process
+    // sampling off); reporting its zeros would look like real data
+    if (snapshot && snapshot->generation > 0) {
+        body += "# TYPE sysmon_processes gauge\n";
+        for (const auto& count : snapshot->counts) {
+            body += "sysmon_processes{state=\"";
+            body += count.first;
+            body += "\"} ";
+            appendValue(body, count.second);
+            body += '\n';
+        }
+        body += "# TYPE sysmon_process_count gauge\nsysmon_process_count ";
+        appendValue(body, (double)snapshot->processes.size());
+        body += '\n';
+    }
+    body += "# EOF\n";
+}
@@ -10,6 +10,7 @@
 #include <vector>
 #include <iostream>
 #include <cmath>
+#include <climits>
 // lib to read from file
 #include <fstream>
 // for the name of the computer and the logged in user
@@ -19,6 +20,7 @@
 #else
 #include <unistd.h>
 #include <limits.h>
+#include <pwd.h>
 #endif
 // this is for us to get the cpu information
 // mostly in unix system
@@ -29,6 +31,8 @@
 #include <sys/types.h>
 #include <sys/sysinfo.h>
 #include <sys/statvfs.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 // for time and date
 #include <ctime>
 // ifconfig ip addresses
@@ -40,12 +44,47 @@
 #include <signal.h>
 #include <algorithm>
 #include <set>
+#include <list>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <functional>
 #include <sstream>
+#include <regex>
 #include <sys/resource.h>
 #include <sys/ioctl.h>
 #include <net/if.h>
 #include <string.h>
+#include <stddef.h>
+// netlink (interface change notifications)
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if_arp.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <sys/syscall.h>
+// sock_diag (per-socket TCP metrics)
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include <linux/tcp.h>
+// taskstats (accounting of exited processes)
+#include <linux/genetlink.h>
+#include <linux/taskstats.h>
+#include <linux/acct.h>
+// process connector (fork/exec/exit events)
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+// metrics exporter (HTTP server)
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <charconv>
+// background samplers
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
 
 using namespace std;
 
@@ -66,17 +105,35 @@ struct CPUStats
 // processes `stat`
 struct Process
 {
-    int pid;
+    int pid = 0;
     string name;
-    char state;
-    long long int vsize;      // Virtual memory size in bytes
-    long long int rss;        // Resident set size in bytes
-    long long int utime;      // User time
-    long long int stime;      // System time
-    float cpu_usage;          // CPU usage percentage
-    float memory_usage;       // Memory usage percentage
-    int ppid;                 // Parent process ID
-    int priority;             // Process priority
+    char state = '?';
+    long long int vsize = 0;  // Virtual memory size in bytes
+    long long int rss = 0;    // Resident set size in bytes, 0 for kernel threads and zombies
+    long long int utime = 0;  // User time
+    long long int stime = 0;  // System time
+    float cpu_usage = 0.0f;   // CPU usage percentage
+    float memory_usage = 0.0f;   // Memory usage percentage
+    int ppid = 0;             // Parent process ID
+    int priority = 0;         // Process priority
+    unsigned long long start_time = 0;   // Clock ticks after boot, tells reused pids apart
+    uid_t uid = (uid_t)-1;    // Real user id
+    
+    // Storage I/O from /proc/[pid]/io, only filled for sampled rows
+    bool io_sampled = false;
+    unsigned long long io_read_bytes = 0;
+    unsigned long long io_write_bytes = 0;
+    unsigned long long io_syscr = 0;
+    unsigned long long io_syscw = 0;
+    float io_read_rate = 0.0f;    // Bytes per second
+    float io_write_rate = 0.0f;
+    
+    // Proportional memory from /proc/[pid]/smaps_rollup, only filled when
+    // memory accounting is on and the background pass has reached the row
+    bool smaps_sampled = false;
+    unsigned long long pss = 0;       // Bytes
+    unsigned long long uss = 0;       // Private_Clean + Private_Dirty
+    unsigned long long swap_pss = 0;
     
     // Get state as string
     string getStateString() const {
@@ -159,12 +216,165 @@ struct RX
     int compressed;
 };
 
+// Pressure Stall Information from /proc/pressure/{cpu,memory,io}
+enum PsiResource {
+    PSI_CPU,
+    PSI_MEMORY,
+    PSI_IO,
+    PSI_RESOURCE_COUNT
+};
+
+struct PsiLine {
+    float avg10;
+    float avg60;
+    float avg300;
+    unsigned long long total;   // Cumulative stall time in microseconds
+};
+
+struct PsiStats {
+    PsiLine some;               // At least one task stalled
+    PsiLine full;               // All non-idle tasks stalled
+    bool has_full;              // Older kernels report no "full" line for cpu
+};
+
+// Samples the three pressure files through held fds and turns the `total`
+// deltas into exact stall percentages for each interval. Optionally arms
+// kernel PSI triggers and waits on them with poll() on a background thread,
+// so stalls are noticed as they happen instead of at the next sample.
+struct PressureMonitor
+{
+    PressureMonitor();
+    ~PressureMonitor();
+
+    bool available(PsiResource resource) const { return fds[resource] >= 0; }
+    void sample();
+
+    // Fires when "some" stall time exceeds threshold_us within window_us
+    bool enableTriggers(unsigned int threshold_us, unsigned int window_us, string& error);
+    void disableTriggers();
+    bool triggersEnabled() const { return triggers_running.load(); }
+    unsigned long triggerCount(PsiResource resource) const { return trigger_counts[resource].load(); }
+    float secondsSinceTrigger(PsiResource resource) const;   // < 0 if never fired
+    bool consumeTrigger() { return triggered.exchange(false); }
+
+    PsiStats stats[PSI_RESOURCE_COUNT];
+    float some_percent[PSI_RESOURCE_COUNT];   // Stall share of the last interval
+    float full_percent[PSI_RESOURCE_COUNT];
+    Graph some_history[PSI_RESOURCE_COUNT];
+    Graph full_history[PSI_RESOURCE_COUNT];
+
+private:
+    void runTriggers();
+
+    int fds[PSI_RESOURCE_COUNT];
+    bool primed;
+    chrono::steady_clock::time_point last_time;
+
+    int trigger_fds[PSI_RESOURCE_COUNT];
+    int wake_fd;
+    atomic<unsigned long> trigger_counts[PSI_RESOURCE_COUNT];
+    atomic<long long> last_trigger_ns[PSI_RESOURCE_COUNT];   // steady_clock, 0 if never
+    atomic<bool> triggered;
+    atomic<bool> triggers_running;
+    thread trigger_worker;
+};
+
+const char* getPsiResourceName(PsiResource resource);
+bool parsePsiText(const char* text, size_t len, PsiStats& stats);
+
+// One cgroup v2 group. cgroup v2 counters are hierarchical, so every value
+// already covers the whole subtree and needs no summing over processes.
+struct CgroupNode {
+    string path;                       // Relative to the cgroup2 root, "/" for the root
+    string name;                       // Last path component
+    int parent;                        // Index into CgroupCollector::nodes, -1 for the root
+    int depth;
+    vector<int> children;
+    int dir_fd;                        // Held directory fd, stat files are opened relative to it
+    nlink_t links;                     // 2 + number of child groups, a change triggers a rescan
+
+    // cpu.stat
+    unsigned long long cpu_usage_usec;
+    unsigned long long cpu_user_usec;
+    unsigned long long cpu_system_usec;
+    unsigned long long nr_throttled;
+    unsigned long long throttled_usec;
+    // memory.current / memory.stat
+    unsigned long long memory_current;
+    unsigned long long memory_anon;
+    unsigned long long memory_file;
+    unsigned long long memory_kernel;
+    // io.stat, summed over devices
+    unsigned long long io_rbytes;
+    unsigned long long io_wbytes;
+    unsigned long long io_rios;
+    unsigned long long io_wios;
+    // *.pressure, "some" avg10
+    float pressure[PSI_RESOURCE_COUNT];
+
+    // Rates over the last interval
+    float cpu_percent;                 // Percent of one CPU
+    float io_read_rate;                // Bytes per second
+    float io_write_rate;
+    bool primed;                       // Has a previous sample to diff against
+};
+
+enum CgroupSortColumn {
+    CGROUP_SORT_NAME,
+    CGROUP_SORT_CPU,
+    CGROUP_SORT_MEMORY,
+    CGROUP_SORT_IO_READ,
+    CGROUP_SORT_IO_WRITE,
+    CGROUP_SORT_CPU_PRESSURE,
+    CGROUP_SORT_MEMORY_PRESSURE,
+    CGROUP_SORT_IO_PRESSURE
+};
+
+// Walks the cgroup2 hierarchy and samples each group's cpu, memory, io and
+// pressure files. Every group keeps an O_DIRECTORY fd; files are read with
+// openat() relative to it. The tree is only rescanned under groups whose
+// link count changed (a child was created or removed), with a full
+// reconciliation every RESCAN_INTERVAL seconds to catch a remove/create
+// pair between samples. Cost per sample scales with the number of cgroups.
+struct CgroupCollector
+{
+    static constexpr float RESCAN_INTERVAL = 10.0f;
+
+    CgroupCollector();
+    ~CgroupCollector();
+
+    bool available() const { return !nodes.empty(); }
+    const string& rootPath() const { return root_path; }
+    void sample();
+
+    // Depth-first order with siblings sorted by column
+    void sortedOrder(CgroupSortColumn column, bool ascending, vector<int>& out) const;
+
+    vector<CgroupNode> nodes;
+
+private:
+    bool open();
+    int addNode(int parent, const string& name, int dir_fd);
+    void scanChildren(int index);
+    void removeSubtree(int index);
+    void compact();
+    bool readNode(CgroupNode& node, double elapsed_sec);
+    ssize_t readFile(int dir_fd, const char* name);   // Length read into read_buffer, -1 on error
+
+    string root_path;
+    bool dirty;                        // Nodes were removed, indices need compacting
+    chrono::steady_clock::time_point last_time;
+    chrono::steady_clock::time_point last_full_scan;
+    vector<char> read_buffer;
+};
+
 // student TODO : system stats
 string CPUinfo();
 const char *getOsName();
 string getUsername();
 string getHostname();
 map<string, int> getProcessCounts();
+map<string, int> getProcessCounts(const vector<Process>& processes);
 float getCPUUsage();
 long getSystemUptime();
 vector<float> getLoadAverage();
@@ -188,30 +398,753 @@ struct MemoryInfo {
     unsigned long used_swap;
 };
 
+// Every field of /proc/meminfo, values in kB unless noted. Fields the
+// running kernel does not report stay zero.
+struct MemInfoSnapshot {
+    unsigned long long mem_total;
+    unsigned long long mem_free;
+    unsigned long long mem_available;
+    unsigned long long buffers;
+    unsigned long long cached;
+    unsigned long long swap_cached;
+    unsigned long long active;
+    unsigned long long inactive;
+    unsigned long long active_anon;
+    unsigned long long inactive_anon;
+    unsigned long long active_file;
+    unsigned long long inactive_file;
+    unsigned long long unevictable;
+    unsigned long long mlocked;
+    unsigned long long high_total;
+    unsigned long long high_free;
+    unsigned long long low_total;
+    unsigned long long low_free;
+    unsigned long long swap_total;
+    unsigned long long swap_free;
+    unsigned long long zswap;
+    unsigned long long zswapped;
+    unsigned long long dirty;
+    unsigned long long writeback;
+    unsigned long long anon_pages;
+    unsigned long long mapped;
+    unsigned long long shmem;
+    unsigned long long kreclaimable;
+    unsigned long long slab;
+    unsigned long long sreclaimable;
+    unsigned long long sunreclaim;
+    unsigned long long kernel_stack;
+    unsigned long long shadow_call_stack;
+    unsigned long long page_tables;
+    unsigned long long sec_page_tables;
+    unsigned long long nfs_unstable;
+    unsigned long long bounce;
+    unsigned long long writeback_tmp;
+    unsigned long long commit_limit;
+    unsigned long long committed_as;
+    unsigned long long vmalloc_total;
+    unsigned long long vmalloc_used;
+    unsigned long long vmalloc_chunk;
+    unsigned long long percpu;
+    unsigned long long hardware_corrupted;
+    unsigned long long anon_huge_pages;
+    unsigned long long shmem_huge_pages;
+    unsigned long long shmem_pmd_mapped;
+    unsigned long long file_huge_pages;
+    unsigned long long file_pmd_mapped;
+    unsigned long long cma_total;
+    unsigned long long cma_free;
+    unsigned long long unaccepted;
+    unsigned long long balloon;
+    unsigned long long hugepages_total;   // pages, not kB
+    unsigned long long hugepages_free;   // pages, not kB
+    unsigned long long hugepages_rsvd;   // pages, not kB
+    unsigned long long hugepages_surp;   // pages, not kB
+    unsigned long long hugepagesize;
+    unsigned long long hugetlb;
+    unsigned long long direct_map4k;
+    unsigned long long direct_map4m;
+    unsigned long long direct_map2m;
+    unsigned long long direct_map1g;
+};
+
 struct DiskInfo {
     unsigned long total_space;
     unsigned long free_space;
     unsigned long used_space;
     string mount_point;
     string original_path;  // Store original mount point path for calculations
+    string device;         // Block device name as in /proc/diskstats (e.g. "sda1")
+    bool unresponsive;     // statvfs missed its deadline (hung NFS/FUSE mount)
 };
 
+// Block device I/O from /proc/diskstats. The file is parsed in one pass into
+// per-device columns; rates are computed from the deltas between samples.
+struct DiskStatsCollector
+{
+    // Raw counters from the last sample
+    vector<string> names;
+    vector<unsigned long long> reads;            // Reads completed
+    vector<unsigned long long> writes;           // Writes completed
+    vector<unsigned long long> sectors_read;     // 512-byte sectors
+    vector<unsigned long long> sectors_written;
+    vector<unsigned long long> read_ms;          // Time spent reading
+    vector<unsigned long long> write_ms;         // Time spent writing
+    vector<unsigned long long> io_ms;            // Time with I/O in flight
+    vector<unsigned long long> weighted_ms;      // Weighted time with I/O in flight
+    vector<unsigned long long> in_flight;        // I/Os currently in progress
+
+    // Rates over the last interval
+    vector<float> read_iops;
+    vector<float> write_iops;
+    vector<float> read_bytes_per_sec;
+    vector<float> write_bytes_per_sec;
+    vector<float> utilization;                   // Percent of time busy
+    vector<float> read_await_ms;                 // Average read latency
+    vector<float> write_await_ms;                // Average write latency
+    vector<float> queue_depth;                   // Average requests in flight
+
+    // History per device (KB/s and utilization %)
+    vector<Graph> read_history;
+    vector<Graph> write_history;
+    vector<Graph> util_history;
+
+    DiskStatsCollector();
+
+    void sample();
+    int findDevice(const string& name) const;
+    int deviceCount() const { return (int)names.size(); }
+
+private:
+    int findDevice(const char* name, size_t len) const;
+    int addDevice(const char* name, size_t len);
+    void removeDevice(int index);
+
+    bool primed;
+    chrono::steady_clock::time_point last_time;
+    vector<char> read_buffer;
+    unsigned long samples;
+    vector<unsigned long> device_seen;           // Sample count when last listed
+    vector<bool> device_primed;                  // Counters hold a previous sample
+};
+
+// Runs statvfs() on worker threads so a hung filesystem can never block the
+// caller. A worker stuck in the kernel stays stuck; the pool spawns another
+// one (up to MAX_WORKERS) so probes of healthy mounts keep flowing.
+struct StatvfsProbePool
+{
+    static const int MAX_WORKERS = 8;
+
+    StatvfsProbePool();
+    ~StatvfsProbePool();
+
+    void submit(const string& path);
+    // Move finished probes into results (never blocks on a filesystem)
+    void collect(vector<DiskInfo>& results);
+
+private:
+    // Shared with detached workers, which may outlive the pool if they hang
+    struct State {
+        mutex lock;
+        condition_variable wake;
+        deque<string> jobs;
+        vector<DiskInfo> results;
+        int workers;
+        int idle_workers;
+        bool shutdown;
+    };
+
+    static void workerLoop(shared_ptr<State> state);
+
+    shared_ptr<State> state;
+};
+
+// Mount table cache. /proc/self/mountinfo is only re-parsed after poll()
+// reports a change (POLLPRI); statvfs capacities refresh on a slower,
+// configurable cadence. Between those, update() only compares timestamps.
+struct MountRegistry
+{
+    MountRegistry();
+    ~MountRegistry();
+
+    void update();
+    void setCapacityInterval(float seconds);
+    float capacityInterval() const { return capacity_interval; }
+    void setProbeDeadline(float seconds) { probe_deadline = seconds; }
+    const vector<DiskInfo>& disks() const { return mounts; }
+
+private:
+    struct ProbeState {
+        bool in_flight;
+        chrono::steady_clock::time_point submitted;
+    };
+
+    void parseMounts();
+    void refreshCapacity();
+    void collectProbes();
+
+    int mountinfo_fd;
+    bool mounts_dirty;
+    float capacity_interval;      // Seconds between statvfs refreshes
+    float check_interval;         // Seconds between change checks
+    chrono::steady_clock::time_point last_check;
+    chrono::steady_clock::time_point last_capacity;
+    vector<DiskInfo> mounts;
+    vector<char> read_buffer;
+    float probe_deadline;         // Seconds before a probe marks its mount unresponsive
+    map<string, ProbeState> probes;  // Keyed by mount path
+    StatvfsProbePool probe_pool;
+    vector<DiskInfo> probe_results;
+};
+
+void parseMemInfoText(const char* text, size_t len, MemInfoSnapshot& snapshot);
+bool parseMemInfo(MemInfoSnapshot& snapshot);
+MemoryInfo getMemoryInfo(const MemInfoSnapshot& snapshot);
 MemoryInfo getMemoryInfo();
 DiskInfo getDiskInfo(const string& path = "/");
 vector<DiskInfo> getAllDisks();
+string getBlockDeviceName(const string& device_path);
 string formatSize(unsigned long size_in_bytes);
+bool readFileInto(const char* path, vector<char>& buffer);
 float getMemoryUsagePercentage();
+float getMemoryUsagePercentage(const MemoryInfo& info);
 float getSwapUsagePercentage();
+float getSwapUsagePercentage(const MemoryInfo& info);
 float getDiskUsagePercentage(const string& path = "/");
+float getDiskUsagePercentage(const DiskInfo& info);
 
 // Process related functions
-Process getProcessInfo(int pid);
+Process getProcessInfo(int pid, unsigned long total_ram = 0);
 vector<Process> getAllProcesses();
 void updateProcessCpuUsage(vector<Process>& processes);
+
+// One thread of a process, from /proc/[pid]/task/[tid]/stat
+struct ThreadInfo {
+    int tid;
+    char name[17];                // comm, at most 16 characters
+    char state;
+    int processor;                // CPU it last ran on (field 39)
+    int priority;
+    int nice;
+    unsigned long long utime;     // Clock ticks
+    unsigned long long stime;
+    float cpu_usage;              // Percent of one CPU over the last interval
+};
+
+// Samples the threads of a single process. Meant to run at a high rate while
+// a details view is open, so a sample does not allocate: the task directory
+// fd is held, entries are listed with getdents64 into a fixed buffer, stat
+// files are read into a fixed buffer, and the current/previous thread
+// vectors are swapped and reused.
+struct ThreadSampler
+{
+    ThreadSampler();
+    ~ThreadSampler();
+
+    bool setPid(int pid);         // false if the process is gone
+    int pid() const { return target_pid; }
+    bool sample();                // false once the process has exited
+    const vector<ThreadInfo>& threads() const { return current; }
+
+private:
+    bool readThread(int tid, ThreadInfo& info);
+
+    int target_pid;
+    int task_fd;
+    vector<ThreadInfo> current;   // Sorted by tid
+    vector<ThreadInfo> previous;
+    chrono::steady_clock::time_point last_time;
+    char dirent_buffer[16384];
+    char stat_buffer[1024];
+};
+
+// Final accounting of a process that has exited
+struct ExitedProcess {
+    int pid;
+    int ppid;
+    unsigned int uid;
+    char name[TS_COMM_LEN + 1];
+    unsigned int exit_code;
+    int threads;                        // Tasks whose accounting was summed
+    double user_sec;
+    double system_sec;
+    double wall_sec;                    // Lifetime
+    unsigned long long max_rss_kb;      // Peak resident set of any of its tasks
+    unsigned long long read_bytes;      // Storage I/O
+    unsigned long long write_bytes;
+    chrono::steady_clock::time_point exit_time;
+
+    double cpuSeconds() const { return user_sec + system_sec; }
+};
+
+// Listens for taskstats exit records over generic netlink, so processes
+// that live for less than a refresh (compilers, cron jobs) are still seen.
+// The kernel sends one record per exiting task; the records of one thread
+// group are summed until the one flagged AGROUP (last task) arrives. Kept
+// in a fixed-size ring, oldest overwritten. Needs CAP_NET_ADMIN.
+struct ExitedProcessMonitor
+{
+    static const int RING_CAPACITY = 4096;
+    static const int MAX_PENDING = 16384;    // Thread groups with exited threads still running
+
+    ExitedProcessMonitor();
+    ~ExitedProcessMonitor();
+
+    bool start(string& error);
+    void stop();
+    bool isRunning() const { return running.load(); }
+
+    // Processes that exited within the last `seconds`, newest first
+    void recent(float seconds, vector<ExitedProcess>& out) const;
+    unsigned long totalExited() const { return total_exited.load(); }
+    unsigned long lostEvents() const { return lost_events.load(); }
+
+private:
+    bool resolveFamily();
+    bool sendCommand(int attr_type, const string& cpumask);
+    void run();
+    void handleMessage(const struct nlmsghdr* msg);
+    void handleTaskExit(const struct taskstats& stats);
+    void record(const ExitedProcess& process);
+
+    int netlink_fd;
+    int wake_fd;
+    unsigned short family_id;
+    string cpumask;
+    unsigned int sequence;
+
+    unordered_map<int, ExitedProcess> pending;   // Keyed by tgid, monitor thread only
+
+    vector<ExitedProcess> ring;
+    size_t ring_next;
+    size_t ring_count;
+    mutable mutex lock;
+
+    atomic<bool> running;
+    atomic<unsigned long> total_exited;
+    atomic<unsigned long> lost_events;
+    thread worker;
+};
+
+struct ProcessIoCounters {
+    unsigned long long read_bytes;    // Bytes fetched from storage
+    unsigned long long write_bytes;   // Bytes sent to storage
+    unsigned long long syscr;         // read()-like syscalls
+    unsigned long long syscw;         // write()-like syscalls
+};
+
+bool readProcessIo(int pid, ProcessIoCounters& counters);
+
+// Per-process I/O rates. /proc/[pid]/io costs an open and a read per
+// process, so only the pids the caller asks for (visible rows, top-N) are
+// read; rates use each pid's own previous reading, whenever that was.
+struct ProcessIoSampler
+{
+    ProcessIoSampler() : generation(0) {}
+
+    void sample(vector<Process>& processes, const set<int>& pids);
+
+private:
+    struct Previous {
+        ProcessIoCounters counters;
+        chrono::steady_clock::time_point time;
+        unsigned long generation;     // Last sample that read this pid
+    };
+
+    unordered_map<int, Previous> previous;
+    unsigned long generation;
+};
+
+// Fork and exit notifications from the kernel process connector
+// (NETLINK_CONNECTOR, CN_IDX_PROC). Needs CAP_NET_ADMIN.
+struct ProcessConnector
+{
+    ProcessConnector() : netlink_fd(-1) {}
+    ~ProcessConnector() { close(); }
+
+    bool open(string& error);
+    void close();
+    bool isOpen() const { return netlink_fd >= 0; }
+
+    // Apply pending events to the pid set without blocking. Returns false
+    // if the kernel dropped events and the set has to be rebuilt.
+    bool drain(unordered_set<int>& pids);
+
+private:
+    bool subscribe(enum proc_cn_mcast_op op);
+
+    int netlink_fd;
+};
+
+// One complete sample of the process table
+struct SmapsRollup {
+    unsigned long long start_time;
+    unsigned long long pss;
+    unsigned long long uss;
+    unsigned long long swap_pss;
+};
+
+bool readSmapsRollup(int pid, SmapsRollup& rollup);
+
+// Walks every process's smaps_rollup on a worker thread, at most once
+// per interval. smaps_rollup costs kernel time proportional to the
+// number of mappings, so the walk is paced to stay within cpu_budget
+// (fraction of one core, measured with the thread CPU clock) and a
+// large host simply takes longer per pass.
+struct SmapsSampler
+{
+    SmapsSampler();
+    ~SmapsSampler();
+
+    void start();
+    void stop();
+    bool isRunning() const;
+    void setInterval(float seconds);
+    void setCpuBudget(float fraction);
+
+    // Processes for the next pass, as (pid, start time)
+    void setTargets(const vector<pair<int, unsigned long long>>& targets);
+    // Fill pss/uss/swap_pss of rows with a result for the same process
+    void apply(vector<Process>& processes) const;
+
+    float lastPassSeconds() const;
+    float cpuUsage() const;           // Fraction of one core over the last pass
+
+private:
+    void run();
+
+    mutable mutex lock;
+    condition_variable wake;
+    thread worker;
+    bool running;
+    float interval;
+    float cpu_budget;
+    vector<pair<int, unsigned long long>> targets;
+    unordered_map<int, SmapsRollup> results;
+    float last_pass_seconds;
+    float last_pass_cpu;
+};
+
+struct ProcessSnapshot {
+    unsigned long generation;
+    vector<Process> processes;
+    map<string, int> counts;          // running / sleeping / stopped / zombie
+    
+    // Filter keys, one per row, built once per sample
+    vector<string> lower_names;
+    vector<string> pid_strings;
+};
+
+// The live process table. The pid set is kept up to date from process
+// connector fork/exit events and only rebuilt with a full /proc readdir
+// every RECONCILE_INTERVAL seconds or after the kernel dropped events;
+// without the connector every sample falls back to a full scan. Each
+// sample publishes an immutable snapshot that all views share. Once
+// started, sampling runs on a background thread every interval seconds,
+// and hooks (alert evaluation) run there right after each publish.
+struct ProcessTable
+{
+    static constexpr float RECONCILE_INTERVAL = 30.0f;
+
+    ProcessTable();
+    ~ProcessTable();
+
+    void start(float interval = 1.0f);
+    void stop();
+    void requestSample();             // Sample now instead of at the next tick
+    void addSampleHook(function<void(const ProcessSnapshot&)> hook);   // Before start()
+
+    void sample();
+    shared_ptr<const ProcessSnapshot> snapshot() const;
+    bool eventDriven() const { return connector.isOpen(); }
+    unsigned long reconcileCount() const { return reconciles; }
+
+    // Optional per-process I/O for the given pids plus the top-N by CPU
+    void setIoSampling(bool enabled, int top_n, const set<int>& pids);
+
+    // Re-read just these pids and republish, dropping the ones that exited.
+    // Queued for the sampler thread once started, so callers don't wait.
+    void patch(const vector<int>& changed);
+
+    // Optional PSS/USS/SwapPss from the background smaps_rollup sampler
+    void setMemoryAccounting(bool enabled, float cpu_budget);
+    const SmapsSampler& memoryAccounting() const { return smaps_sampler; }
+
+private:
+    void reconcile();
+    void run();
+    void applyPatch(const vector<int>& changed);
+
+    // Serializes sample() and applyPatch(), which both own the pid set
+    mutex sample_lock;
+    ProcessConnector connector;
+    string connector_error;
+    unordered_set<int> pids;
+    chrono::steady_clock::time_point last_reconcile;
+    atomic<unsigned long> reconciles;
+
+    bool io_enabled;
+    int io_top_n;
+    set<int> io_pids;
+    ProcessIoSampler io_sampler;
+    SmapsSampler smaps_sampler;
+
+    unsigned long generation;
+    shared_ptr<const ProcessSnapshot> published;
+    mutable mutex lock;
+
+    vector<function<void(const ProcessSnapshot&)>> hooks;
+    condition_variable wake;
+    thread worker;
+    bool running;
+    bool sample_requested;
+    vector<int> pending_patch;        // Guarded by lock
+    float interval;
+};
+
+// Parent/child structure of one process snapshot in compressed sparse
+// row form: the children of row r are child_rows[child_offsets[r]] up to
+// child_rows[child_offsets[r + 1]]. Rows are listed depth-first in
+// preorder, so a subtree is the contiguous range starting at its root.
+struct ProcessTree
+{
+    ProcessTree() : generation(0) {}
+
+    // Rebuild only when the snapshot generation changed
+    void update(const shared_ptr<const ProcessSnapshot>& snapshot);
+
+    int find(int pid) const;   // Row of pid, -1 if not in the snapshot
+    void subtree(int row, vector<int>& rows) const;   // Appends row and its descendants
+    const Process& process(int row) const { return source->processes[row]; }
+    size_t childCount(int row) const { return child_offsets[row + 1] - child_offsets[row]; }
+    const int* childrenBegin(int row) const { return child_rows.data() + child_offsets[row]; }
+    const int* childrenEnd(int row) const { return child_rows.data() + child_offsets[row + 1]; }
+
+    shared_ptr<const ProcessSnapshot> source;
+    unsigned long generation;
+    vector<int> child_offsets;        // rows + 1 entries
+    vector<int> child_rows;
+    vector<int> preorder;             // Rows in display order
+    vector<int> depth;                // Per row
+    vector<int> subtree_size;         // Per row, including the row itself
+    vector<float> subtree_cpu;        // Per row, summed over the subtree
+    vector<float> subtree_memory;
+
+private:
+    vector<int> by_pid;               // Rows sorted by pid, for find()
+};
+
+enum ProcessSortColumn {
+    PROCESS_SORT_PID,
+    PROCESS_SORT_NAME,
+    PROCESS_SORT_STATE,
+    PROCESS_SORT_CPU,
+    PROCESS_SORT_MEMORY,
+    PROCESS_SORT_IO_READ,
+    PROCESS_SORT_IO_WRITE,
+    PROCESS_SORT_PSS,
+    PROCESS_SORT_USS,
+    PROCESS_SORT_SWAP_PSS,
+    PROCESS_SORT_COLUMN_COUNT
+};
+
+// uid to user name from a single /etc/passwd parse, reloaded only when
+// the file changes. Unknown uids map to their number.
+struct UserNameCache
+{
+    static constexpr float RELOAD_CHECK_INTERVAL = 10.0f;
+
+    UserNameCache() : loaded_mtime(0) {}
+
+    const string& name(uid_t uid);
+
+private:
+    void load();
+
+    unordered_map<uid_t, string> names;
+    time_t loaded_mtime;
+    chrono::steady_clock::time_point last_check;
+};
+
+// Full command lines, read from /proc/[pid]/cmdline only when a row asks
+// for one and kept per (pid, start time) so a reused pid is read again.
+// Processes gone from the latest snapshot are dropped by prune().
+struct CommandLineCache
+{
+    CommandLineCache() : generation(0) {}
+
+    const string& get(const Process& proc) { return lookup(proc).command; }
+    const string& getLower(const Process& proc) { return lookup(proc).lower_command; }
+    void prune(const ProcessSnapshot& snapshot);
+    size_t size() const { return entries.size(); }
+
+private:
+    // Arguments can be rewritten in place (setproctitle), so visible rows
+    // are re-read every few snapshots even when nothing else changed
+    static const unsigned long REFRESH_SNAPSHOTS = 10;
+
+    struct Entry {
+        unsigned long long start_time;
+        unsigned long seen;           // Last snapshot generation that had it
+        unsigned long fetched;        // Generation the command was read in
+        string name;                  // comm at read time; changes on exec
+        string command;
+        string lower_command;         // For case-insensitive filters
+    };
+
+    Entry& lookup(const Process& proc);
+
+    unordered_map<int, Entry> entries;
+    unsigned long generation;
+};
+
+enum ProcessFilterField {
+    FILTER_TEXT,                      // Name or pid substring
+    FILTER_NAME,
+    FILTER_USER,
+    FILTER_STATE,
+    FILTER_REGEX,
+    FILTER_COMMAND,                   // Command line substring
+    FILTER_PID,
+    FILTER_CPU,
+    FILTER_MEMORY
+};
+
+enum ProcessFilterCompare {
+    FILTER_LESS,
+    FILTER_LESS_EQUAL,
+    FILTER_EQUAL,
+    FILTER_GREATER_EQUAL,
+    FILTER_GREATER
+};
+
+struct ProcessFilterTerm {
+    ProcessFilterField field;
+    bool negate;
+    ProcessFilterCompare compare;
+    string text;                      // Lowercase substring, or accepted state letters
+    double value;
+    uid_t uid;
+    shared_ptr<const regex> pattern;
+};
+
+// Process table query, compiled once per edit. Whitespace separated terms
+// must all match: plain text (name or pid substring), name:, user:,
+// state:, cmd:, re: or /regex/, and cpu, mem or pid compared with <, <=,
+// =, >= or >. A leading ! negates a term. Text is matched
+// case-insensitively against the lowercase names and pid strings kept in
+// the snapshot. cmd: terms are evaluated last, so command lines are only
+// fetched for rows that passed every other term.
+struct ProcessFilter
+{
+    ProcessFilter() : revision(0), commands(nullptr) {}
+
+    void setCommandLineCache(CommandLineCache* cache) { commands = cache; }
+
+    // On error the previous query stays in effect
+    bool compile(const string& query, string& error);
+    bool empty() const { return terms.empty(); }
+    bool matches(const ProcessSnapshot& snapshot, size_t row) const;
+
+    unsigned long revision;           // Bumped by every successful compile
+
+private:
+    vector<ProcessFilterTerm> terms;
+    CommandLineCache* commands;
+};
+
+// Permutation of a snapshot's rows in display order. The order is only
+// recomputed when the snapshot or the sort key changes, and only as far
+// as rows are actually requested: sortedPrefix(n) extends the ordered
+// prefix with a partial sort, so a clipped table pays for the rows on
+// screen rather than the whole table. Ties are broken by pid so the
+// order is total and an extended prefix always agrees with a full sort.
+// With a filter only matching rows are kept, so order doubles as the
+// filtered index and is reused until the query or the data changes.
+struct ProcessSortIndex
+{
+    ProcessSortIndex() : generation(0), column(PROCESS_SORT_PID), ascending(true), filter_revision(0), sorted(0) {}
+
+    void update(const shared_ptr<const ProcessSnapshot>& snapshot, ProcessSortColumn column, bool ascending,
+                const ProcessFilter* filter = nullptr);
+
+    // Guarantee rows [0, n) of order are final; returns the usable count
+    size_t sortedPrefix(size_t n);
+
+    size_t size() const { return order.size(); }
+    const Process& process(size_t position) const { return source->processes[order[position]]; }
+
+    vector<int> order;
+
+private:
+    shared_ptr<const ProcessSnapshot> source;
+    unsigned long generation;
+    ProcessSortColumn column;
+    bool ascending;
+    unsigned long filter_revision;
+    size_t sorted;                    // Length of the final prefix of order
+};
+
+// One process an action applies to. A non-zero start_time is checked
+// after the pidfd is opened so a pid reused since selection is skipped.
+struct ProcessActionTarget {
+    int pid;
+    unsigned long long start_time;
+    string name;
+};
+
+struct ProcessActionResult {
+    unsigned long batch;
+    int pid;
+    string name;
+    int error;                        // errno, 0 if the signal was delivered
+    bool exited;                      // Seen exiting within EXIT_WAIT_MS
+};
+
+// Sends a signal to a batch of processes on a worker thread. Each target
+// is pinned with pidfd_open() and signalled with pidfd_send_signal(), so
+// a pid recycled after selection cannot be hit. A cgroup batch lists the
+// group and its descendants itself and, for SIGKILL, uses cgroup.kill
+// when the kernel has it. Per-pid results are picked up with collect().
+struct ProcessActionRunner
+{
+    static constexpr int EXIT_WAIT_MS = 1000;
+
+    ProcessActionRunner();
+    ~ProcessActionRunner();
+
+    unsigned long submit(int signal, const vector<ProcessActionTarget>& targets);
+    unsigned long submitCgroup(int signal, const string& cgroup_dir);
+    // Move finished results into results (never blocks on the worker)
+    void collect(vector<ProcessActionResult>& results);
+    bool busy() const;
+
+    static string cgroupOf(int pid, const string& cgroup_root);   // "" if unknown
+
+private:
+    struct Batch {
+        unsigned long id;
+        int signal;
+        vector<ProcessActionTarget> targets;
+        string cgroup_dir;            // Set for cgroup batches
+    };
+
+    void start();
+    void run();
+    void execute(Batch& batch, vector<ProcessActionResult>& out);
+
+    mutable mutex lock;
+    condition_variable wake;
+    thread worker;
+    bool running;
+    deque<Batch> queue;
+    bool executing;
+    vector<ProcessActionResult> finished;
+    unsigned long next_batch;
+};
+
 string getProcessName(int pid);
+unsigned long long readProcessStartTime(int pid);
 bool killProcess(int pid);
-map<int, vector<int>> buildProcessTree();
-vector<Process> getProcessChildren(int pid);
 int getProcessPriority(int pid);
 bool setProcessPriority(int pid, int priority);
 
@@ -219,6 +1152,7 @@ bool setProcessPriority(int pid, int priority);
 struct NetworkInterface {
     string name;
     string ipv4_address;
+    string ipv6_address;
     string mac_address;
     bool is_up;
     string type;
@@ -241,6 +1175,77 @@ struct NetworkConnection {
     string state;
     int pid;
     string process_name;
+    unsigned int tx_queue;      // Bytes in the send queue
+    unsigned int rx_queue;      // Bytes in the receive queue
+    unsigned int retransmits;   // Unrecovered RTO timeouts
+    unsigned long inode;
+    unsigned int remote_ip;     // IPv4, network byte order
+    unsigned short local_port;
+    unsigned short remote_port;
+    int state_code;             // Kernel TCP state number
+};
+
+// Hash aggregation over a connection snapshot
+enum ConnectionGroupBy {
+    GROUP_BY_REMOTE_IP,
+    GROUP_BY_REMOTE_PORT,
+    GROUP_BY_LOCAL_PORT,
+    GROUP_BY_STATE,
+    GROUP_BY_PROCESS
+};
+
+struct ConnectionGroup {
+    uint64_t key;
+    int count;
+    unsigned long long tx_queue;  // Sum of send queue bytes
+    unsigned long long rx_queue;  // Sum of receive queue bytes
+    string label;
+};
+
+// Groups connections with a flat open-addressing hash table. The table is
+// reused between runs and cleared by bumping a stamp, so steady-state
+// aggregation does not allocate.
+struct ConnectionAggregator
+{
+    ConnectionAggregator();
+
+    void aggregate(const vector<NetworkConnection>& connections, ConnectionGroupBy group_by,
+                   vector<ConnectionGroup>& groups);
+
+    static uint64_t groupKey(const NetworkConnection& conn, ConnectionGroupBy group_by);
+    static string groupLabel(uint64_t key, ConnectionGroupBy group_by);
+
+private:
+    struct Bucket {
+        uint64_t key;
+        uint32_t group;   // Index into the output groups
+        uint32_t stamp;   // Bucket is live only if stamp == current_stamp
+    };
+
+    void reserve(size_t count);
+
+    vector<Bucket> buckets;   // Power of two size
+    uint32_t current_stamp;
+};
+
+// Per-socket TCP metrics from sock_diag (INET_DIAG_INFO / struct tcp_info)
+struct TcpConnectionMetrics {
+    string local_address;
+    string remote_address;
+    string state;
+    unsigned long inode;
+    unsigned int uid;
+    float srtt_ms;              // Smoothed round trip time
+    float rttvar_ms;            // Round trip time variance
+    unsigned int snd_cwnd;      // Congestion window in segments
+    unsigned int retransmits;   // Current unrecovered retransmits
+    unsigned int total_retrans; // Retransmitted segments over the connection lifetime
+    unsigned long long bytes_acked;
+    unsigned long long bytes_received;
+    unsigned long long bytes_sent;
+    unsigned long long delivery_rate; // Bytes per second
+    unsigned int send_queue;    // Unacknowledged bytes (wqueue)
+    unsigned int recv_queue;    // Unread bytes (rqueue)
 };
 
 struct PortInfo {
@@ -253,14 +1258,654 @@ struct PortInfo {
 
 typedef Graph NetworkGraph;
 
+// Per-interface traffic history. A background thread samples every interface
+// in /proc/net/dev, so switching the selected interface shows its full history
+// instead of restarting the rate computation. All rx/tx series live in a
+// single buffer allocated up front (one slot per interface).
+struct NetworkGraphRegistry
+{
+    static const int MAX_INTERFACES = 64;
+
+    struct Slot {
+        string name;
+        bool used;
+        bool primed;                 // have a previous sample to diff against
+        unsigned long last_rx_bytes;
+        unsigned long last_tx_bytes;
+        chrono::steady_clock::time_point last_time;
+        int values_offset;
+    };
+
+    NetworkGraphRegistry();
+    ~NetworkGraphRegistry();
+
+    void start();
+    void stop();
+    void setInterval(float seconds);
+
+    // Copy the KB/s history for an interface into the display graphs.
+    // Returns false if the interface has no slot yet.
+    bool copyHistory(const string& interface_name, NetworkGraph& rx_graph, NetworkGraph& tx_graph);
+
+    // Take one sample of every interface (called by the background thread).
+    void sample();
+
+private:
+    float* rxSeries(int slot) { return &series[(size_t)slot * 2 * Graph::MAX_VALUES]; }
+    float* txSeries(int slot) { return &series[((size_t)slot * 2 + 1) * Graph::MAX_VALUES]; }
+    int findSlot(const string& interface_name) const;
+    int allocSlot(const string& interface_name);
+    void run();
+
+    vector<float> series;            // MAX_INTERFACES * 2 * Graph::MAX_VALUES
+    Slot slots[MAX_INTERFACES];
+    mutable mutex lock;
+    condition_variable wake;
+    thread worker;
+    bool running;
+    float interval;
+};
+
+// In-memory interface table driven by rtnetlink (RTNLGRP_LINK and
+// RTNLGRP_IPV4/IPV6_IFADDR). A background thread blocks on the netlink socket
+// and only touches the model when the kernel reports a change.
+struct NetlinkInterfaceMonitor
+{
+    NetlinkInterfaceMonitor();
+    ~NetlinkInterfaceMonitor();
+
+    bool start();                    // false if netlink is unavailable
+    void stop();
+    void requestResync();            // re-dump links and addresses
+
+    // Bumped on every model change; compare before copying.
+    unsigned long generation() const { return model_generation.load(); }
+    unsigned long snapshot(vector<NetworkInterface>& out) const;
+
+private:
+    struct Link {
+        string name;
+        string mac_address;
+        unsigned int flags;
+        unsigned short arp_type;
+        vector<string> ipv4_addresses;
+        vector<string> ipv6_addresses;
+    };
+
+    void run();
+    bool dump(int type);
+    bool receive(unsigned int wait_seq);
+    void handleMessage(const struct nlmsghdr* msg);
+    void publish();
+
+    int netlink_fd;
+    int wake_fd;
+    unsigned int sequence;
+    map<int, Link> links;            // owned by the monitor thread
+    vector<NetworkInterface> published;
+    mutable mutex lock;
+    atomic<unsigned long> model_generation;
+    atomic<bool> running;
+    atomic<bool> resync_requested;
+    thread worker;
+};
+
 vector<NetworkInterface> getNetworkInterfaces();
 string getMacAddress(const string& interface_name);
 string getInterfaceType(const string& interface_name);
 bool isInterfaceUp(const string& interface_name);
 NetworkStats getNetworkStats(const string& interface_name);
-void updateNetworkGraph(NetworkGraph& rx_graph, NetworkGraph& tx_graph, const string& interface_name);
+vector<NetworkStats> getAllNetworkStats();
+void updateNetworkGraph(NetworkGraphRegistry& registry, NetworkGraph& rx_graph, NetworkGraph& tx_graph, const string& interface_name);
+// Per-process network throughput, attributed by summing tcp_info byte
+// counters of each process's sockets (inode -> pid from /proc/[pid]/fd).
+struct ProcessTraffic {
+    int pid;
+    string process_name;
+    int sockets;
+    float tx_rate;               // Bytes per second
+    float rx_rate;               // Bytes per second
+    unsigned long long tx_bytes; // Bytes sent during the last interval
+    unsigned long long rx_bytes; // Bytes received during the last interval
+};
+
+struct ProcessNetworkAccounting
+{
+    static const size_t MAX_TRACKED_SOCKETS = 65536;
+
+    ProcessNetworkAccounting();
+    ~ProcessNetworkAccounting();
+
+    void start();
+    void stop();
+    bool isRunning() const { return running; }
+    void setInterval(float seconds);
+
+    // Top talkers from the last interval, highest total rate first
+    vector<ProcessTraffic> topTalkers() const;
+
+    // Take one sample and recompute the top talkers (called by the background thread)
+    void sample();
+
+private:
+    struct SocketCounters {
+        unsigned long inode;
+        unsigned long seen;                  // Last pass that listed it
+        unsigned long long bytes_sent;
+        unsigned long long bytes_received;
+    };
+
+    void run();
+
+    // LRU of per-socket counters, most recently seen first. Sockets that
+    // close fall to the back and are evicted once the list is full; live
+    // sockets never are, so the list grows with the live set if it has to.
+    list<SocketCounters> lru;
+    unordered_map<unsigned long, list<SocketCounters>::iterator> lru_index;
+    unsigned long passes;
+    bool primed;
+    chrono::steady_clock::time_point last_time;
+    map<pair<int, unsigned long long>, string> name_cache;   // (pid, start time) -> name
+
+    vector<ProcessTraffic> talkers;
+    mutable mutex lock;
+    condition_variable wake;
+    thread worker;
+    bool running;
+    float interval;
+};
+
+unordered_map<unsigned long, int> getSocketInodeOwners();
+void assignConnectionOwners(vector<NetworkConnection>& connections);
 vector<NetworkConnection> getActiveConnections();
+vector<TcpConnectionMetrics> getTcpConnectionMetrics();
+string getTcpStateName(int state);
 vector<PortInfo> getListeningPorts();
 string getProcessNameFromPid(int pid);
 
+// metric series
+
+// One sample of every system-wide series. Series are named by dotted
+// paths ("cpu.usage", "cpu.3.usage", "disk.sda.read_await_ms",
+// "net.eth0.rx_bytes_per_sec"); the names vector is shared between
+// samples and only replaced when a core, disk or interface comes or goes.
+struct SystemSample {
+    unsigned long generation;
+    double time;                      // steady_clock seconds
+    double wall_time;                 // Unix time in seconds
+    shared_ptr<const vector<string>> names;
+    vector<double> values;            // Parallel to *names
+};
+
+// Samples CPU (total and per core), load, temperature, fan, memory, swap,
+// PSI, block device and interface rates on its own thread at a fixed
+// interval, whichever tabs are visible, and publishes an immutable
+// SystemSample. Hooks (metric rules) run on that thread after each
+// publish. Collectors are private to the sampler, so it never disturbs the
+// deltas behind the UI graphs.
+struct SystemSampler
+{
+    SystemSampler();
+    ~SystemSampler();
+
+    void start(float interval = 1.0f);
+    void stop();
+    void addSampleHook(function<void(const SystemSample&)> hook);   // Before start()
+
+    void sample();
+    shared_ptr<const SystemSample> latest() const;
+
+private:
+    struct CpuTimes {
+        unsigned long long busy;
+        unsigned long long total;
+    };
+
+    struct InterfaceBytes {
+        unsigned long long rx;
+        unsigned long long tx;
+        unsigned long seen;           // Sample count when last listed
+    };
+
+    void sampleCpu();
+    void add(const char* name, double value);
+    void add(const char* group, const string& instance, const char* field, double value);
+    void run();
+
+    PressureMonitor pressure;
+    DiskStatsCollector disks;
+    MemInfoSnapshot meminfo;
+    vector<CpuTimes> cpu_times;       // [0] is the aggregate "cpu" line
+    unordered_map<string, InterfaceBytes> interfaces;
+    unsigned long samples;
+    bool primed;
+    chrono::steady_clock::time_point last_time;
+    vector<char> read_buffer;
+
+    // Built by each sample; slot strings keep their capacity
+    vector<string> pending_names;
+    vector<double> pending_values;
+    size_t pending_count;
+    shared_ptr<const vector<string>> names;
+
+    unsigned long generation;
+    shared_ptr<const SystemSample> published;
+    mutable mutex lock;
+
+    vector<function<void(const SystemSample&)>> hooks;
+    condition_variable wake;
+    thread worker;
+    bool running;
+    float interval;
+};
+
+// alerts
+
+// Single producer, single consumer ring. push() and pop() never block or
+// allocate slots; a full queue rejects the push.
+template <typename T, size_t Capacity>
+struct SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    SpscQueue() : head(0), tail(0) {}
+
+    // Producer thread only
+    bool push(const T& value) {
+        size_t write = tail.load(memory_order_relaxed);
+        if (write - head.load(memory_order_acquire) == Capacity) return false;
+        slots[write & (Capacity - 1)] = value;
+        tail.store(write + 1, memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool pop(T& value) {
+        size_t read = head.load(memory_order_relaxed);
+        if (read == tail.load(memory_order_acquire)) return false;
+        value = move(slots[read & (Capacity - 1)]);
+        head.store(read + 1, memory_order_release);
+        return true;
+    }
+
+private:
+    T slots[Capacity];
+    alignas(64) atomic<size_t> head;
+    alignas(64) atomic<size_t> tail;
+};
+
+enum AlertMatchField {
+    ALERT_MATCH_NAME,
+    ALERT_MATCH_CMDLINE,
+    ALERT_MATCH_CGROUP
+};
+
+enum AlertMetric {
+    ALERT_METRIC_CPU,
+    ALERT_METRIC_MEMORY
+};
+
+// Fires for every process whose name, command line or cgroup matches
+// pattern (case-insensitive regex) once metric has stayed above
+// raise_threshold for sustain_seconds, and clears when it falls to
+// clear_threshold or below.
+struct ProcessAlertRule {
+    int id;
+    AlertMatchField field;
+    string pattern;
+    AlertMetric metric;
+    float raise_threshold;
+    float clear_threshold;
+    float sustain_seconds;
+};
+
+struct AlertEvent {
+    time_t time;
+    int rule_id;
+    int pid;
+    string process_name;
+    bool raised;                      // false: cleared, or the process exited
+    float value;
+};
+
+// Evaluates process alert rules against every published snapshot, on the
+// process table's sampler thread. Which rules apply to a process is
+// decided once per process instance (pid, start time, name) and kept in
+// a pid-keyed hash index, so a sample costs one lookup per process plus
+// the rules it matched. Events go to a lock-free queue drained by the UI
+// and, optionally, to a log file.
+struct ProcessAlertEngine
+{
+    static const size_t QUEUE_CAPACITY = 1024;
+
+    ProcessAlertEngine();
+    ~ProcessAlertEngine();
+
+    // UI side
+    bool setRules(const vector<ProcessAlertRule>& rules, string& error);
+    bool setLogFile(const string& path, string& error);   // "" closes it
+    bool pollEvent(AlertEvent& event);
+    unsigned long droppedEvents() const { return dropped; }
+
+    // Sampler side
+    void evaluate(const ProcessSnapshot& snapshot);
+
+    static const char* metricName(AlertMetric metric);
+
+private:
+    struct CompiledRule {
+        ProcessAlertRule rule;
+        regex pattern;
+    };
+
+    struct RuleState {
+        int rule;                     // Index into compiled, valid for rules_revision
+        int rule_id;
+        bool above;
+        bool active;
+        chrono::steady_clock::time_point above_since;
+        float value;
+    };
+
+    struct Tracked {
+        unsigned long long start_time;
+        string name;
+        unsigned long rules_revision;
+        unsigned long seen;
+        vector<RuleState> matches;
+    };
+
+    void matchRules(int pid, Tracked& entry);
+    void emit(const AlertEvent& event);
+
+    mutex lock;                       // Rules and log file, shared with the UI
+    vector<CompiledRule> compiled;
+    unsigned long rules_revision;
+    bool needs_cmdline;
+    bool needs_cgroup;
+    FILE* log_file;
+
+    unordered_map<int, Tracked> index;
+    // Rules matching a given name / command line / cgroup, so each distinct
+    // subject runs the regexes once per rule set
+    unordered_map<string, vector<int>> subject_matches[3];
+    unsigned long generation;
+    SpscQueue<AlertEvent, QUEUE_CAPACITY> events;
+    atomic<unsigned long> dropped;
+};
+
+enum MetricAggregate {
+    METRIC_AGGREGATE_LAST,
+    METRIC_AGGREGATE_AVG,
+    METRIC_AGGREGATE_MIN,
+    METRIC_AGGREGATE_MAX,
+    METRIC_AGGREGATE_RATE             // Change per second across the window
+};
+
+// Time window over one series with O(1) amortized push and queries: a
+// running sum gives the mean, monotonic deques give the min and max, and
+// the oldest and newest samples give the rate of change.
+struct SlidingWindow
+{
+    SlidingWindow() : length(0.0), sum(0.0), first_time(-1.0) {}
+
+    void setLength(double seconds) { length = seconds; }
+
+    void push(double time, double value) {
+        if (first_time < 0.0) first_time = time;
+        samples.push_back({time, value});
+        sum += value;
+        while (!min_samples.empty() && min_samples.back().second >= value) min_samples.pop_back();
+        min_samples.push_back({time, value});
+        while (!max_samples.empty() && max_samples.back().second <= value) max_samples.pop_back();
+        max_samples.push_back({time, value});
+        
+        // Evict samples that fell out of the window
+        while (samples.front().first < time - length) {
+            double old_time = samples.front().first;
+            sum -= samples.front().second;
+            if (min_samples.front().first == old_time) min_samples.pop_front();
+            if (max_samples.front().first == old_time) max_samples.pop_front();
+            samples.pop_front();
+        }
+    }
+
+    // The window has seen a full length of data
+    bool full() const { return !samples.empty() && samples.back().first - first_time >= length; }
+    size_t count() const { return samples.size(); }
+    double last() const { return samples.back().second; }
+    double mean() const { return sum / samples.size(); }
+    double minimum() const { return min_samples.front().second; }
+    double maximum() const { return max_samples.front().second; }
+    double rate() const {
+        double span = samples.back().first - samples.front().first;
+        return span > 0.0 ? (samples.back().second - samples.front().second) / span : 0.0;
+    }
+
+private:
+    double length;
+    double sum;
+    double first_time;
+    deque<pair<double, double>> samples;       // (time, value)
+    deque<pair<double, double>> min_samples;   // Increasing values
+    deque<pair<double, double>> max_samples;   // Decreasing values
+};
+
+// "avg(cpu.usage, 30s) > 90", "rate(thermal.cpu, 10s) > 2 clear 0.5",
+// "min(swap.free_percent, 5m) < 10" or just "fan.speed < 500". A '*' in
+// the series name matches any run of characters, so one rule can cover
+// every disk or interface ("max(disk.*.read_await_ms, 30s) > 50"). The
+// alert clears once the aggregate is back past clear_threshold.
+struct MetricAlertRule {
+    int id;
+    string text;                      // As written
+    string series;
+    MetricAggregate aggregate;
+    double window_seconds;
+    bool above;                       // ">" rather than "<"
+    double threshold;
+    double clear_threshold;
+};
+
+bool parseMetricRule(const string& text, MetricAlertRule& rule, string& error);
+const char* getMetricAggregateName(MetricAggregate aggregate);
+
+struct MetricAlertEvent {
+    time_t time;
+    int rule_id;
+    string series;
+    bool raised;
+    double value;
+};
+
+// Evaluates metric rules against every SystemSample, on the system
+// sampler's thread. Each rule is bound to the series it matches once per
+// names layout, and keeps one sliding window per series, so a sample
+// costs O(1) per bound rule. Rule changes from the UI are picked up at the
+// next sample; events go back through a lock-free queue.
+struct MetricRuleEngine
+{
+    static const size_t QUEUE_CAPACITY = 256;
+
+    MetricRuleEngine();
+
+    // UI side
+    void setRules(const vector<MetricAlertRule>& rules);
+    bool pollEvent(MetricAlertEvent& event);
+    unsigned long droppedEvents() const { return dropped; }
+
+    // Sampler side
+    void evaluate(const SystemSample& sample);
+
+private:
+    struct Instance {
+        string series;
+        int index;                    // Into the bound names
+        SlidingWindow window;
+        bool active;
+        double value;
+    };
+
+    struct BoundRule {
+        MetricAlertRule rule;
+        vector<Instance> instances;
+    };
+
+    void bind(const SystemSample& sample);
+    void emit(const MetricAlertEvent& event);
+
+    mutex lock;                       // pending and revision, shared with the UI
+    vector<MetricAlertRule> pending;
+    unsigned long revision;
+
+    vector<BoundRule> bound;
+    unsigned long bound_revision;
+    shared_ptr<const vector<string>> bound_names;
+    SpscQueue<MetricAlertEvent, QUEUE_CAPACITY> events;
+    atomic<unsigned long> dropped;
+};
+
+// exporter
+
+// Serves the latest published system and process samples on a local HTTP
+// endpoint (GET /metrics) in OpenMetrics text format. One thread drives a
+// non-blocking listen socket and its connections through epoll. The body
+// is only re-rendered when a sampler has published since the last scrape,
+// into a buffer that keeps its capacity, so a scrape never reads /proc and
+// usually costs one writev().
+struct MetricsExporter
+{
+    static const int MAX_CONNECTIONS = 64;
+    static constexpr float IDLE_TIMEOUT = 30.0f;   // Seconds
+
+    MetricsExporter();
+    ~MetricsExporter();
+
+    bool start(const string& address, int port, const SystemSampler* system, const ProcessTable* processes, string& error);
+    void stop();
+    bool isRunning() const { return running; }
+    unsigned long scrapeCount() const { return scrapes; }
+
+private:
+    struct Connection {
+        int fd;                       // -1 for a free slot
+        char request[2048];
+        size_t request_len;
+        char header[256];
+        size_t header_len;
+        size_t sent;                  // Bytes of header + body written so far
+        bool sending;
+        bool keep_alive;
+        bool metrics;                 // Response carries the metrics body
+        const char* status_body;      // Short body of an error response
+        chrono::steady_clock::time_point last_active;
+    };
+
+    // Rendering order: a literal line when index is -1, otherwise a sample
+    // prefix ("name{label=\"x\"} ") followed by the value of that series
+    struct LayoutEntry {
+        string text;
+        int index;
+    };
+
+    void run();
+    void acceptConnections();
+    void readRequest(Connection& connection);
+    void respond(Connection& connection);
+    void writeResponse(Connection& connection);
+    void closeConnection(Connection& connection);
+    void layout(const vector<string>& names);
+    void render();
+
+    const SystemSampler* system;
+    const ProcessTable* processes;
+
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;
+    vector<Connection> connections;
+    int sending_count;
+
+    shared_ptr<const vector<string>> layout_names;
+    vector<LayoutEntry> layout_entries;
+    unsigned long system_generation;
+    unsigned long process_generation;
+    string body;
+
+    thread worker;
+    atomic<bool> running;
+    atomic<unsigned long> scrapes;
+};
+
+// stream output
+
+// Writes number as text: integers exactly, fractions in the shortest form
+// that round-trips as a float. Returns the end of the written text.
+char* formatMetricValue(char* first, char* last, double value);
+
+enum StreamFormat {
+    STREAM_NDJSON,
+    STREAM_CSV
+};
+
+// Streams system samples and process tables as NDJSON (one object per
+// record, "kind" tells them apart) or CSV (first column is the kind; a
+// "#kind,..." header row precedes a kind's rows in every file and is
+// repeated when the system series change). Records are formatted straight
+// into one fixed buffer with to_chars and written out in large blocks, so
+// steady-state sampling allocates nothing. The file can rotate by size,
+// keeping path.1 .. path.N.
+struct StreamWriter
+{
+    static const size_t BUFFER_SIZE = 1 << 20;
+    static const size_t MAX_FIELD = 1024;   // Room reserved per field
+
+    StreamWriter();
+    ~StreamWriter();
+
+    // "-" writes to stdout; rotate_bytes 0 never rotates
+    bool open(const string& path, StreamFormat format, unsigned long long rotate_bytes, int keep_files, string& error);
+    void close();
+    bool isOpen() const { return fd != -1; }
+
+    // Safe to call from the sampler threads concurrently
+    void writeSystem(const SystemSample& sample);
+    void writeProcesses(const ProcessSnapshot& snapshot);
+    unsigned long long bytesWritten() const { return total_bytes; }
+
+private:
+    void beginRecord(const char* kind, double time);
+    void endRecord();
+    void key(const char* name);
+    void put(const char* text, size_t len);
+    void put(char c) { reserve(1); buffer[used++] = c; }
+    void putNumber(double value);
+    void putText(const char* text, size_t len);
+    void reserve(size_t bytes);
+    void finishRecords();             // Flush on time, rotate on size
+    void flush();
+    bool rotate();
+
+    mutex lock;
+    atomic<int> fd;                   // flush() closes it on write errors; isOpen() reads it unlocked
+    string path;
+    StreamFormat format;
+    unsigned long long rotate_bytes;
+    int keep_files;
+    unsigned long long file_bytes;    // Flushed into the current file
+    unsigned long long total_bytes;
+    unique_ptr<char[]> buffer;
+    size_t used;
+    chrono::steady_clock::time_point last_flush;
+
+    // Unix time with millisecond precision, formatted once per sample
+    double stamp_time;
+    char stamp[32];
+    size_t stamp_len;
+
+    // CSV headers already written to the current file
+    shared_ptr<const vector<string>> csv_system_names;
+    bool csv_process_header;
+};
+
 #endif
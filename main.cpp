@@ -7,22 +7,21 @@ FanGraph g_fanGraph;
 ThermalGraph g_thermalGraph;
 NetworkGraph g_rxGraph;
 NetworkGraph g_txGraph;
-
-// Process monitoring alerts
-struct ProcessAlert {
-    int pid;
-    string name;
-    float cpu_threshold;
-    float memory_threshold;
-    bool cpu_alert_active;
-    bool memory_alert_active;
-    
-    ProcessAlert(int p, const string& n, float cpu, float mem)
-        : pid(p), name(n), cpu_threshold(cpu), memory_threshold(mem),
-          cpu_alert_active(false), memory_alert_active(false) {}
-};
-
-vector<ProcessAlert> g_process_alerts;
+NetworkGraphRegistry g_netRegistry;
+NetlinkInterfaceMonitor g_netlinkMonitor;
+bool g_netlinkAvailable = false;
+ProcessNetworkAccounting g_netAccounting;
+DiskStatsCollector g_diskStats;
+MountRegistry g_mounts;
+PressureMonitor g_pressure;
+CgroupCollector g_cgroups;
+ExitedProcessMonitor g_exitedProcesses;
+string g_exitedProcessesError;
+ProcessTable g_processTable;
+ProcessAlertEngine g_processAlerts;
+SystemSampler g_systemSampler;
+MetricRuleEngine g_metricRules;
+MetricsExporter g_exporter;
 
 /*
 NOTE : You are free to change the code as you wish, the main objective is to make the
@@ -205,14 +204,178 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
             ImGui::EndTabItem();
         }
         
+        // Pressure Tab
+        if (ImGui::BeginTabItem("Pressure")) {
+            if (!g_pressure.available(PSI_CPU) && !g_pressure.available(PSI_MEMORY) && !g_pressure.available(PSI_IO)) {
+                ImGui::TextDisabled("PSI not available (kernel needs CONFIG_PSI and psi=1)");
+            } else {
+                // Event-driven triggers, re-armed whenever the settings change
+                static bool use_triggers = false;
+                static int threshold_ms = 100;
+                static int window_s = 2;
+                static string trigger_error;
+                bool changed = ImGui::Checkbox("Stall triggers", &use_triggers);
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(100);
+                // Sliders re-arm once released, not on every frame of a drag
+                ImGui::SliderInt("Threshold (ms)", &threshold_ms, 10, 1000);
+                changed |= ImGui::IsItemDeactivatedAfterEdit();
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(80);
+                // Unprivileged triggers only accept windows that are multiples of 2s
+                if (ImGui::SliderInt("Window (s)", &window_s, 2, 10)) window_s -= window_s % 2;
+                changed |= ImGui::IsItemDeactivatedAfterEdit();
+                if (changed) {
+                    trigger_error.clear();
+                    if (use_triggers) {
+                        if (!g_pressure.enableTriggers(threshold_ms * 1000, window_s * 1000000, trigger_error)) {
+                            use_triggers = false;
+                        }
+                    } else {
+                        g_pressure.disableTriggers();
+                    }
+                }
+                if (!trigger_error.empty()) {
+                    ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "%s", trigger_error.c_str());
+                }
+                
+                for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+                    PsiResource resource = (PsiResource)i;
+                    if (!g_pressure.available(resource)) continue;
+                    const PsiStats& stats = g_pressure.stats[i];
+                    
+                    ImGui::Separator();
+                    ImGui::Text("%s  some %.2f / %.2f / %.2f", getPsiResourceName(resource),
+                                stats.some.avg10, stats.some.avg60, stats.some.avg300);
+                    if (stats.has_full) {
+                        ImGui::SameLine();
+                        ImGui::Text("  full %.2f / %.2f / %.2f", stats.full.avg10, stats.full.avg60, stats.full.avg300);
+                    }
+                    if (g_pressure.triggersEnabled()) {
+                        float ago = g_pressure.secondsSinceTrigger(resource);
+                        ImGui::SameLine();
+                        if (ago < 0.0f) {
+                            ImGui::TextDisabled("  no stall events");
+                        } else {
+                            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "  %lu events, last %.1fs ago",
+                                               g_pressure.triggerCount(resource), ago);
+                        }
+                    }
+                    
+                    float width = stats.has_full ? ImGui::GetContentRegionAvail().x * 0.5f - 4.0f : ImGui::GetContentRegionAvail().x;
+                    const Graph& some = g_pressure.some_history[i];
+                    string some_label = "some " + to_string((int)g_pressure.some_percent[i]) + "%";
+                    ImGui::PlotLines((string("##psisome") + to_string(i)).c_str(), some.values, Graph::MAX_VALUES,
+                                     some.values_offset, some_label.c_str(), 0.0f, 100.0f, ImVec2(width, 50));
+                    if (stats.has_full) {
+                        ImGui::SameLine();
+                        const Graph& full = g_pressure.full_history[i];
+                        string full_label = "full " + to_string((int)g_pressure.full_percent[i]) + "%";
+                        ImGui::PlotLines((string("##psifull") + to_string(i)).c_str(), full.values, Graph::MAX_VALUES,
+                                         full.values_offset, full_label.c_str(), 0.0f, 100.0f, ImVec2(width, 50));
+                    }
+                }
+            }
+            
+            ImGui::EndTabItem();
+        }
+        
+        // Threshold rules over any system series
+        static vector<MetricAlertRule> metric_rules;
+        static map<pair<int, string>, double> active_metric_alerts;
+        static deque<MetricAlertEvent> metric_history;
+        MetricAlertEvent metric_event;
+        while (g_metricRules.pollEvent(metric_event)) {
+            auto key = make_pair(metric_event.rule_id, metric_event.series);
+            if (metric_event.raised) active_metric_alerts[key] = metric_event.value;
+            else active_metric_alerts.erase(key);
+            metric_history.push_front(metric_event);
+            if (metric_history.size() > 200) metric_history.pop_back();
+        }
+        
+        string rules_label = active_metric_alerts.empty() ? "Rules" : "Rules (" + to_string(active_metric_alerts.size()) + ")";
+        if (ImGui::BeginTabItem((rules_label + "###rules").c_str())) {
+            static char rule_text[256] = "avg(cpu.usage, 30s) > 90";
+            static string rule_error;
+            static int next_rule_id = 1;
+            ImGui::SetNextItemWidth(320);
+            bool submitted = ImGui::InputText("##ruletext", rule_text, IM_ARRAYSIZE(rule_text), ImGuiInputTextFlags_EnterReturnsTrue);
+            ImGui::SameLine();
+            if (ImGui::Button("Add Rule") || submitted) {
+                MetricAlertRule rule;
+                rule_error.clear();
+                if (parseMetricRule(rule_text, rule, rule_error)) {
+                    rule.id = next_rule_id++;
+                    metric_rules.push_back(rule);
+                    g_metricRules.setRules(metric_rules);
+                }
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("avg|min|max|rate(series, window) > or < threshold [clear value]\n"
+                                  "e.g. rate(thermal.cpu, 10s) > 2, max(disk.*.read_await_ms, 30s) > 50 clear 20\n"
+                                  "or a bare series for its latest value: fan.speed < 500");
+            }
+            if (!rule_error.empty()) {
+                ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", rule_error.c_str());
+            }
+            
+            for (size_t i = 0; i < metric_rules.size(); i++) {
+                ImGui::PushID(metric_rules[i].id);
+                bool remove = ImGui::SmallButton("Remove");
+                ImGui::SameLine();
+                ImGui::Text("#%d %s", metric_rules[i].id, metric_rules[i].text.c_str());
+                ImGui::PopID();
+                if (remove) {
+                    metric_rules.erase(metric_rules.begin() + i);
+                    g_metricRules.setRules(metric_rules);
+                    break;
+                }
+            }
+            
+            ImGui::Separator();
+            for (const auto& alert : active_metric_alerts) {
+                ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "ALERT #%d %s = %.2f",
+                                   alert.first.first, alert.first.second.c_str(), alert.second);
+            }
+            if (ImGui::TreeNode("Recent events")) {
+                ImGui::Text("%lu dropped", g_metricRules.droppedEvents());
+                for (const auto& event : metric_history) {
+                    char stamp[16];
+                    struct tm local;
+                    localtime_r(&event.time, &local);
+                    strftime(stamp, sizeof(stamp), "%H:%M:%S", &local);
+                    ImGui::Text("%s %s #%d %s %.2f", stamp, event.raised ? "raised " : "cleared",
+                                event.rule_id, event.series.c_str(), event.value);
+                }
+                ImGui::TreePop();
+            }
+            if (ImGui::TreeNode("Series")) {
+                shared_ptr<const SystemSample> latest = g_systemSampler.latest();
+                for (size_t i = 0; i < latest->values.size(); i++) {
+                    ImGui::Text("%-36s %.2f", (*latest->names)[i].c_str(), latest->values[i]);
+                }
+                ImGui::TreePop();
+            }
+            
+            ImGui::EndTabItem();
+        }
+        
         ImGui::EndTabBar();
     }
     
+    // Sample PSI every second, or right away when a trigger fired
+    static float last_pressure_time = -1.0f;
+    float pressure_elapsed = ImGui::GetTime() - last_pressure_time;
+    if (pressure_elapsed >= 1.0f || (pressure_elapsed >= 0.1f && g_pressure.consumeTrigger())) {
+        g_pressure.sample();
+        last_pressure_time = ImGui::GetTime();
+    }
+    
     ImGui::Spacing();
     ImGui::Text("Process Information");
     ImGui::Separator();
     
-    map<string, int> processes = getProcessCounts();
+    map<string, int> processes = g_processTable.snapshot()->counts;
     ImGui::Text("Running: %d", processes["running"]);
     ImGui::Text("Sleeping: %d", processes["sleeping"]);
     ImGui::Text("Stopped: %d", processes["stopped"]);
@@ -224,6 +387,12 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
     ImGui::End();
 }
 
+// Signals offered for process actions
+static const struct { int number; const char* name; } ACTION_SIGNALS[] = {
+    {SIGTERM, "SIGTERM"}, {SIGKILL, "SIGKILL"}, {SIGINT, "SIGINT"}, {SIGHUP, "SIGHUP"},
+    {SIGSTOP, "SIGSTOP"}, {SIGCONT, "SIGCONT"}, {SIGUSR1, "SIGUSR1"}, {SIGUSR2, "SIGUSR2"}
+};
+
 // memoryProcessesWindow, display information for the memory and processes information
 void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
 {
@@ -235,11 +404,17 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
     ImGui::Text("Memory Information");
     ImGui::Separator();
     
-    // Get memory info
-    MemoryInfo mem_info = getMemoryInfo();
+    // Parse /proc/meminfo once per sample, everything below reads the snapshot
+    static MemInfoSnapshot meminfo = {0};
+    static float last_meminfo_time = -1.0f;
+    if (last_meminfo_time < 0.0f || ImGui::GetTime() - last_meminfo_time >= 1.0f) {
+        parseMemInfo(meminfo);
+        last_meminfo_time = ImGui::GetTime();
+    }
+    MemoryInfo mem_info = getMemoryInfo(meminfo);
     
     // RAM usage
-    float ram_percentage = getMemoryUsagePercentage();
+    float ram_percentage = getMemoryUsagePercentage(mem_info);
     ImGui::Text("RAM Usage: %.1f%%", ram_percentage);
     ImGui::Text("Total: %s", formatSize(mem_info.total_ram).c_str());
     ImGui::Text("Used: %s", formatSize(mem_info.used_ram).c_str());
@@ -252,7 +427,7 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
     ImGui::Spacing();
     
     // SWAP usage
-    float swap_percentage = getSwapUsagePercentage();
+    float swap_percentage = getSwapUsagePercentage(mem_info);
     ImGui::Text("SWAP Usage: %.1f%%", swap_percentage);
     ImGui::Text("Total: %s", formatSize(mem_info.total_swap).c_str());
     ImGui::Text("Used: %s", formatSize(mem_info.used_swap).c_str());
@@ -262,6 +437,53 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
     ImGui::ProgressBar(swap_percentage / 100.0f, ImVec2(-1, 0), 
                        (formatSize(mem_info.used_swap) + " / " + formatSize(mem_info.total_swap)).c_str());
     
+    // Remaining meminfo fields, already in the snapshot
+    if (ImGui::CollapsingHeader("Extended memory")) {
+        auto kb = [](unsigned long long value) { return formatSize(value * 1024); };
+        if (ImGui::BeginTable("ExtendedMemory", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            struct Row { const char* label; string value; };
+            const Row rows[] = {
+                {"Available", kb(meminfo.mem_available)},
+                {"Buffers", kb(meminfo.buffers)},
+                {"Cached", kb(meminfo.cached)},
+                {"Swap cached", kb(meminfo.swap_cached)},
+                {"Active", kb(meminfo.active)},
+                {"Inactive", kb(meminfo.inactive)},
+                {"Dirty", kb(meminfo.dirty)},
+                {"Writeback", kb(meminfo.writeback)},
+                {"Anon pages", kb(meminfo.anon_pages)},
+                {"Mapped", kb(meminfo.mapped)},
+                {"Shmem", kb(meminfo.shmem)},
+                {"Slab", kb(meminfo.slab)},
+                {"SReclaimable", kb(meminfo.sreclaimable)},
+                {"SUnreclaim", kb(meminfo.sunreclaim)},
+                {"Kernel stack", kb(meminfo.kernel_stack)},
+                {"Page tables", kb(meminfo.page_tables)},
+                {"Commit limit", kb(meminfo.commit_limit)},
+                {"Committed_AS", kb(meminfo.committed_as)},
+                {"Vmalloc used", kb(meminfo.vmalloc_used)},
+                {"Anon huge pages", kb(meminfo.anon_huge_pages)},
+                {"HugePages total", to_string(meminfo.hugepages_total)},
+                {"HugePages free", to_string(meminfo.hugepages_free)},
+                {"Hugepage size", kb(meminfo.hugepagesize)},
+                {"Hugetlb", kb(meminfo.hugetlb)},
+            };
+            ImGui::TableSetupColumn("Field");
+            ImGui::TableSetupColumn("Value");
+            ImGui::TableSetupColumn("Field");
+            ImGui::TableSetupColumn("Value");
+            ImGui::TableHeadersRow();
+            for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); i++) {
+                if (i % 2 == 0) ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(rows[i].label);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(rows[i].value.c_str());
+            }
+            ImGui::EndTable();
+        }
+    }
+    
     ImGui::Spacing();
     ImGui::Separator();
     
@@ -269,12 +491,27 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
     ImGui::Text("Disk Usage");
     ImGui::Separator();
     
-    // Get all disks
-    vector<DiskInfo> disks = getAllDisks();
+    // Mount table and capacities are cached, nothing is read from disk per frame
+    g_mounts.update();
+    const vector<DiskInfo>& disks = g_mounts.disks();
+    
+    // Sample block device I/O every second
+    static float last_diskstats_time = -1.0f;
+    if (ImGui::GetTime() - last_diskstats_time >= 1.0f) {
+        g_diskStats.sample();
+        last_diskstats_time = ImGui::GetTime();
+    }
     
     for (const auto& disk : disks) {
-        float disk_percentage = getDiskUsagePercentage(disk.original_path);
-        ImGui::Text("%s: %.1f%%", disk.mount_point.c_str(), disk_percentage);
+        if (disk.unresponsive) {
+            // Probe missed its deadline, show the last known numbers
+            ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "%s: stale / unresponsive", disk.mount_point.c_str());
+        }
+        if (disk.total_space == 0) continue;
+        float disk_percentage = getDiskUsagePercentage(disk);
+        if (!disk.unresponsive) {
+            ImGui::Text("%s: %.1f%%", disk.mount_point.c_str(), disk_percentage);
+        }
         ImGui::Text("Total: %s", formatSize(disk.total_space).c_str());
         ImGui::Text("Used: %s", formatSize(disk.used_space).c_str());
         ImGui::Text("Free: %s", formatSize(disk.free_space).c_str());
@@ -283,32 +520,255 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
         ImGui::ProgressBar(disk_percentage / 100.0f, ImVec2(-1, 0), 
                            (formatSize(disk.used_space) + " / " + formatSize(disk.total_space)).c_str());
         
+        // I/O of the backing block device
+        int device = g_diskStats.findDevice(disk.device);
+        if (device >= 0) {
+            ImGui::Text("I/O: R %s/s (%.0f IOPS)  W %s/s (%.0f IOPS)  Util %.1f%%  Await %.2f/%.2f ms",
+                        formatSize((unsigned long)g_diskStats.read_bytes_per_sec[device]).c_str(), g_diskStats.read_iops[device],
+                        formatSize((unsigned long)g_diskStats.write_bytes_per_sec[device]).c_str(), g_diskStats.write_iops[device],
+                        g_diskStats.utilization[device], g_diskStats.read_await_ms[device], g_diskStats.write_await_ms[device]);
+        }
+        
         ImGui::Spacing();
     }
     
+    // Capacity refresh cadence
+    float capacity_interval = g_mounts.capacityInterval();
+    ImGui::SetNextItemWidth(120);
+    if (ImGui::SliderFloat("Capacity refresh (s)", &capacity_interval, 1.0f, 60.0f, "%.0f")) {
+        g_mounts.setCapacityInterval(capacity_interval);
+    }
+    
+    // Per-device I/O table and history
+    if (ImGui::CollapsingHeader("Disk I/O")) {
+        static int selected_device = 0;
+        if (ImGui::BeginTable("DiskIO", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Device");
+            ImGui::TableSetupColumn("Read/s");
+            ImGui::TableSetupColumn("Write/s");
+            ImGui::TableSetupColumn("R IOPS");
+            ImGui::TableSetupColumn("W IOPS");
+            ImGui::TableSetupColumn("Util%");
+            ImGui::TableSetupColumn("Await R/W ms");
+            ImGui::TableSetupColumn("Queue");
+            ImGui::TableHeadersRow();
+            
+            for (int i = 0; i < g_diskStats.deviceCount(); i++) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                if (ImGui::Selectable(g_diskStats.names[i].c_str(), selected_device == i, ImGuiSelectableFlags_SpanAllColumns)) {
+                    selected_device = i;
+                }
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%s", formatSize((unsigned long)g_diskStats.read_bytes_per_sec[i]).c_str());
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%s", formatSize((unsigned long)g_diskStats.write_bytes_per_sec[i]).c_str());
+                ImGui::TableSetColumnIndex(3);
+                ImGui::Text("%.0f", g_diskStats.read_iops[i]);
+                ImGui::TableSetColumnIndex(4);
+                ImGui::Text("%.0f", g_diskStats.write_iops[i]);
+                ImGui::TableSetColumnIndex(5);
+                ImGui::Text("%.1f", g_diskStats.utilization[i]);
+                ImGui::TableSetColumnIndex(6);
+                ImGui::Text("%.2f / %.2f", g_diskStats.read_await_ms[i], g_diskStats.write_await_ms[i]);
+                ImGui::TableSetColumnIndex(7);
+                ImGui::Text("%.2f", g_diskStats.queue_depth[i]);
+            }
+            
+            ImGui::EndTable();
+        }
+        
+        if (selected_device < g_diskStats.deviceCount()) {
+            const Graph& read_graph = g_diskStats.read_history[selected_device];
+            const Graph& write_graph = g_diskStats.write_history[selected_device];
+            const Graph& util_graph = g_diskStats.util_history[selected_device];
+            float graph_width = ImGui::GetContentRegionAvail().x;
+            ImGui::PlotLines("##diskread", read_graph.values, Graph::MAX_VALUES, read_graph.values_offset,
+                             (g_diskStats.names[selected_device] + " read KB/s").c_str(), 0.0f, FLT_MAX, ImVec2(graph_width, 60));
+            ImGui::PlotLines("##diskwrite", write_graph.values, Graph::MAX_VALUES, write_graph.values_offset,
+                             (g_diskStats.names[selected_device] + " write KB/s").c_str(), 0.0f, FLT_MAX, ImVec2(graph_width, 60));
+            ImGui::PlotLines("##diskutil", util_graph.values, Graph::MAX_VALUES, util_graph.values_offset,
+                             (g_diskStats.names[selected_device] + " util %").c_str(), 0.0f, 100.0f, ImVec2(graph_width, 60));
+        }
+    }
+    
+    // cgroup v2 tree, sampled only while the section is open
+    if (ImGui::CollapsingHeader("Control Groups")) {
+        if (!g_cgroups.available()) {
+            ImGui::TextDisabled("No cgroup2 hierarchy mounted");
+        } else {
+            static float last_cgroup_time = -1.0f;
+            static bool cgroups_dirty = true;
+            if (last_cgroup_time < 0.0f || ImGui::GetTime() - last_cgroup_time >= 1.0f) {
+                g_cgroups.sample();
+                last_cgroup_time = ImGui::GetTime();
+                cgroups_dirty = true;
+            }
+            ImGui::Text("%s: %d groups", g_cgroups.rootPath().c_str(), (int)g_cgroups.nodes.size());
+            
+            ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Sortable |
+                                    ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable;
+            if (ImGui::BeginTable("Cgroups", 8, flags, ImVec2(0, 250))) {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("Cgroup", ImGuiTableColumnFlags_WidthStretch, 3.0f);
+                ImGui::TableSetupColumn("CPU%", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+                ImGui::TableSetupColumn("Memory", ImGuiTableColumnFlags_PreferSortDescending);
+                ImGui::TableSetupColumn("Read/s", ImGuiTableColumnFlags_PreferSortDescending);
+                ImGui::TableSetupColumn("Write/s", ImGuiTableColumnFlags_PreferSortDescending);
+                ImGui::TableSetupColumn("CPU psi", ImGuiTableColumnFlags_PreferSortDescending);
+                ImGui::TableSetupColumn("Mem psi", ImGuiTableColumnFlags_PreferSortDescending);
+                ImGui::TableSetupColumn("IO psi", ImGuiTableColumnFlags_PreferSortDescending);
+                ImGui::TableHeadersRow();
+                
+                // Siblings are re-sorted only after a sample or a header click
+                static vector<int> order;
+                ImGuiTableSortSpecs* sort_specs = ImGui::TableGetSortSpecs();
+                if (sort_specs && (sort_specs->SpecsDirty || cgroups_dirty)) {
+                    CgroupSortColumn column = CGROUP_SORT_CPU;
+                    bool ascending = false;
+                    if (sort_specs->SpecsCount > 0) {
+                        column = (CgroupSortColumn)sort_specs->Specs[0].ColumnIndex;
+                        ascending = sort_specs->Specs[0].SortDirection == ImGuiSortDirection_Ascending;
+                    }
+                    g_cgroups.sortedOrder(column, ascending, order);
+                    sort_specs->SpecsDirty = false;
+                    cgroups_dirty = false;
+                }
+                
+                // Rows below a collapsed group are skipped
+                int collapsed_depth = INT_MAX;
+                for (int index : order) {
+                    const CgroupNode& node = g_cgroups.nodes[index];
+                    if (node.depth > collapsed_depth) continue;
+                    collapsed_depth = INT_MAX;
+                    
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    float indent = node.depth * ImGui::GetStyle().IndentSpacing;
+                    if (indent > 0) ImGui::Indent(indent);
+                    ImGuiTreeNodeFlags node_flags = ImGuiTreeNodeFlags_NoTreePushOnOpen | ImGuiTreeNodeFlags_SpanFullWidth;
+                    if (node.children.empty()) node_flags |= ImGuiTreeNodeFlags_Leaf;
+                    if (node.depth == 0) node_flags |= ImGuiTreeNodeFlags_DefaultOpen;
+                    bool open = ImGui::TreeNodeEx(node.path.c_str(), node_flags, "%s", node.depth == 0 ? node.path.c_str() : node.name.c_str());
+                    if (indent > 0) ImGui::Unindent(indent);
+                    if (!open) collapsed_depth = node.depth;
+                    
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%.1f", node.cpu_percent);
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::Text("%s", node.memory_current ? formatSize(node.memory_current).c_str() : "-");
+                    ImGui::TableSetColumnIndex(3);
+                    ImGui::Text("%s", formatSize((unsigned long)node.io_read_rate).c_str());
+                    ImGui::TableSetColumnIndex(4);
+                    ImGui::Text("%s", formatSize((unsigned long)node.io_write_rate).c_str());
+                    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+                        ImGui::TableSetColumnIndex(5 + i);
+                        ImGui::Text("%.2f", node.pressure[i]);
+                    }
+                }
+                
+                ImGui::EndTable();
+            }
+        }
+    }
+    
+    // Short-lived processes the 1s table never sees, from taskstats
+    if (ImGui::CollapsingHeader("Exited Processes")) {
+        if (!g_exitedProcesses.isRunning()) {
+            ImGui::TextDisabled("Unavailable: %s", g_exitedProcessesError.c_str());
+        } else {
+            static float window_seconds = 60.0f;
+            ImGui::SetNextItemWidth(120);
+            ImGui::SliderFloat("Exited in last (s)", &window_seconds, 5.0f, 600.0f, "%.0f");
+            
+            static vector<ExitedProcess> exited;
+            static float last_exited_time = -1.0f;
+            if (last_exited_time < 0.0f || ImGui::GetTime() - last_exited_time >= 1.0f) {
+                g_exitedProcesses.recent(window_seconds, exited);
+                sort(exited.begin(), exited.end(), [](const ExitedProcess& a, const ExitedProcess& b) {
+                    return a.cpuSeconds() > b.cpuSeconds();
+                });
+                last_exited_time = ImGui::GetTime();
+            }
+            
+            double total_cpu = 0.0;
+            for (const auto& process : exited) total_cpu += process.cpuSeconds();
+            ImGui::Text("%d exited, %.2f CPU-seconds (%lu since start, %lu records lost)",
+                        (int)exited.size(), total_cpu, g_exitedProcesses.totalExited(), g_exitedProcesses.lostEvents());
+            
+            if (ImGui::BeginTable("ExitedProcesses", 9, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                                  ImVec2(0, 200))) {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("PID");
+                ImGui::TableSetupColumn("Name");
+                ImGui::TableSetupColumn("PPID");
+                ImGui::TableSetupColumn("CPU s");
+                ImGui::TableSetupColumn("User/Sys s");
+                ImGui::TableSetupColumn("Lifetime s");
+                ImGui::TableSetupColumn("Peak RSS");
+                ImGui::TableSetupColumn("Read/Write");
+                ImGui::TableSetupColumn("Exit");
+                ImGui::TableHeadersRow();
+                
+                ImGuiListClipper clipper;
+                clipper.Begin((int)exited.size());
+                while (clipper.Step()) {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                        const ExitedProcess& process = exited[row];
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::Text("%d", process.pid);
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::TextUnformatted(process.name);
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::Text("%d", process.ppid);
+                        ImGui::TableSetColumnIndex(3);
+                        ImGui::Text("%.3f", process.cpuSeconds());
+                        ImGui::TableSetColumnIndex(4);
+                        ImGui::Text("%.3f / %.3f", process.user_sec, process.system_sec);
+                        ImGui::TableSetColumnIndex(5);
+                        ImGui::Text("%.3f", process.wall_sec);
+                        ImGui::TableSetColumnIndex(6);
+                        ImGui::Text("%s", formatSize(process.max_rss_kb * 1024).c_str());
+                        ImGui::TableSetColumnIndex(7);
+                        ImGui::Text("%s / %s", formatSize(process.read_bytes).c_str(), formatSize(process.write_bytes).c_str());
+                        ImGui::TableSetColumnIndex(8);
+                        // Wait status: terminating signal in the low bits, exit code above
+                        if (process.exit_code & 0x7f) ImGui::Text("sig %u", process.exit_code & 0x7f);
+                        else ImGui::Text("%u", (process.exit_code >> 8) & 0xff);
+                    }
+                }
+                
+                ImGui::EndTable();
+            }
+        }
+    }
+    
     // Process Table Section
     ImGui::Spacing();
     ImGui::Separator();
     ImGui::Text("Process Table");
     ImGui::Separator();
     
+    // Alert events arrive from the sampler thread; keep the open ones and a short history
+    static map<pair<int, int>, AlertEvent> active_alerts;   // (rule id, pid)
+    static deque<AlertEvent> alert_history;
+    AlertEvent alert_event;
+    while (g_processAlerts.pollEvent(alert_event)) {
+        auto key = make_pair(alert_event.rule_id, alert_event.pid);
+        if (alert_event.raised) active_alerts[key] = alert_event;
+        else active_alerts.erase(key);
+        alert_history.push_front(alert_event);
+        if (alert_history.size() > 200) alert_history.pop_back();
+    }
+    
     // Display active alerts
-    if (!g_process_alerts.empty()) {
+    if (!active_alerts.empty()) {
         ImGui::Text("Active Alerts:");
-        for (const auto& alert : g_process_alerts) {
-            if (alert.cpu_alert_active || alert.memory_alert_active) {
-                ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s (PID: %d): ", alert.name.c_str(), alert.pid);
-                
-                if (alert.cpu_alert_active) {
-                    ImGui::SameLine();
-                    ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "CPU > %.1f%% ", alert.cpu_threshold);
-                }
-                
-                if (alert.memory_alert_active) {
-                    ImGui::SameLine();
-                    ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Memory > %.1f%%", alert.memory_threshold);
-                }
-            }
+        for (const auto& entry : active_alerts) {
+            const AlertEvent& alert = entry.second;
+            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s (PID: %d): rule #%d, %.1f",
+                               alert.process_name.c_str(), alert.pid, alert.rule_id, alert.value);
         }
         ImGui::Separator();
     }
@@ -316,73 +776,64 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
     // Process view options
     static bool tree_view = false;
     
-    // Process statistics summary
-    map<string, int> proc_stats = getProcessCounts();
+    // Process statistics summary, from the same sampled table as the list
+    shared_ptr<const ProcessSnapshot> snapshot = g_processTable.snapshot();
+    map<string, int> proc_stats = snapshot->counts;
     int total_procs = proc_stats["running"] + proc_stats["sleeping"] + proc_stats["stopped"] + proc_stats["zombie"];
     ImGui::Text("Total: %d | Running: %d | Sleeping: %d | Stopped: %d | Zombie: %d", 
                total_procs, proc_stats["running"], proc_stats["sleeping"], 
                proc_stats["stopped"], proc_stats["zombie"]);
+    ImGui::SameLine();
+    ImGui::TextDisabled("(%s, %lu full scans)", g_processTable.eventDriven() ? "event-driven" : "polling /proc",
+                        g_processTable.reconcileCount());
     
-    // Process filter
+    // Process filter, compiled only when the text changes
     static char filter_text[128] = "";
+    static ProcessFilter process_filter;
+    static string filter_error;
+    
+    // Command lines and user names, resolved only for rows that need them
+    static CommandLineCache command_lines;
+    static UserNameCache user_names;
+    process_filter.setCommandLineCache(&command_lines);
     ImGui::Text("Filter:");
     ImGui::SameLine();
-    ImGui::InputText("##filter", filter_text, IM_ARRAYSIZE(filter_text));
+    if (ImGui::InputText("##filter", filter_text, IM_ARRAYSIZE(filter_text))) {
+        process_filter.compile(filter_text, filter_error);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Terms must all match: text, name:x, user:x, state:x, re:x or /x/,\n"
+                          "cmd:x, cpu>5, mem>=1, pid<100; prefix ! to negate");
+    }
+    if (!filter_error.empty()) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", filter_error.c_str());
+    }
     
-    // Get all processes and update CPU usage
-    static vector<Process> processes;
-    static float last_update_time = 0.0f;
-    float current_time = ImGui::GetTime();
+    // Optional per-process I/O, read only for rows on screen and the top-N by CPU
+    static bool show_io = false;
+    static int io_top_n = 20;
+    static set<int> visible_pids;
+    g_processTable.setIoSampling(show_io, io_top_n, visible_pids);
     
-    // Update process list every second
-    if (current_time - last_update_time >= 1.0f) {
-        processes = getAllProcesses();
-        updateProcessCpuUsage(processes);
-        last_update_time = current_time;
-        
-        // Check process alerts
-        for (auto& alert : g_process_alerts) {
-            bool found = false;
-            for (const auto& proc : processes) {
-                if (proc.pid == alert.pid) {
-                    found = true;
-                    
-                    // Check CPU threshold
-                    if (proc.cpu_usage > alert.cpu_threshold && !alert.cpu_alert_active) {
-                        alert.cpu_alert_active = true;
-                        // In a real application, you might show a notification or log this event
-                    } else if (proc.cpu_usage <= alert.cpu_threshold) {
-                        alert.cpu_alert_active = false;
-                    }
-                    
-                    // Check memory threshold
-                    if (proc.memory_usage > alert.memory_threshold && !alert.memory_alert_active) {
-                        alert.memory_alert_active = true;
-                        // In a real application, you might show a notification or log this event
-                    } else if (proc.memory_usage <= alert.memory_threshold) {
-                        alert.memory_alert_active = false;
-                    }
-                    
-                    break;
-                }
-            }
-            
-            // Process no longer exists
-            if (!found) {
-                // In a real application, you might want to remove the alert or mark it as inactive
-            }
-        }
-    }
+    // Optional PSS/USS/SwapPss, walked in the background within a CPU budget
+    static bool show_smaps = false;
+    static float smaps_budget_percent = 2.0f;
+    g_processTable.setMemoryAccounting(show_smaps, smaps_budget_percent / 100.0f);
+    
+    const vector<Process>& processes = snapshot->processes;
     
     // Process table
     ImGui::BeginChild("ProcessTable", ImVec2(0, 300), true);
     
     // Sorting options
-    static int sort_column = 0; // 0=PID, 1=Name, 2=State, 3=CPU%, 4=Memory%
+    static int sort_column = 0; // 0=PID, 1=Name, 2=State, 3=CPU%, 4=Memory%, 5=Read/s, 6=Write/s, 7=PSS, 8=USS, 9=Swap
     static bool sort_ascending = true;
+    if (!show_io && (sort_column == 5 || sort_column == 6)) sort_column = 0;
+    if (!show_smaps && sort_column >= 7) sort_column = 0;
     
     // Table headers with sorting
-    ImGui::Columns(5, "ProcessTableColumns");
+    ImGui::Columns(7 + (show_io ? 2 : 0) + (show_smaps ? 3 : 0), "ProcessTableColumns");
     
     // PID column header
     if (ImGui::Selectable("PID")) {
@@ -398,6 +849,9 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
     }
     ImGui::NextColumn();
     
+    ImGui::Text("User");
+    ImGui::NextColumn();
+    
     // State column header
     if (ImGui::Selectable("State")) {
         if (sort_column == 2) sort_ascending = !sort_ascending;
@@ -419,122 +873,135 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
     }
     ImGui::NextColumn();
     
+    // I/O column headers
+    if (show_io) {
+        if (ImGui::Selectable("Read/s")) {
+            if (sort_column == 5) sort_ascending = !sort_ascending;
+            else { sort_column = 5; sort_ascending = false; }
+        }
+        ImGui::NextColumn();
+        if (ImGui::Selectable("Write/s")) {
+            if (sort_column == 6) sort_ascending = !sort_ascending;
+            else { sort_column = 6; sort_ascending = false; }
+        }
+        ImGui::NextColumn();
+    }
+    
+    // Memory accounting column headers
+    if (show_smaps) {
+        const char* smaps_headers[] = {"PSS", "USS", "Swap"};
+        for (int i = 0; i < 3; i++) {
+            if (ImGui::Selectable(smaps_headers[i])) {
+                if (sort_column == 7 + i) sort_ascending = !sort_ascending;
+                else { sort_column = 7 + i; sort_ascending = false; }
+            }
+            ImGui::NextColumn();
+        }
+    }
+    
+    ImGui::Text("Command");
+    ImGui::NextColumn();
+    
     ImGui::Separator();
     
-    // Sort processes based on selected column
-    vector<Process> sorted_processes = processes;
-    sort(sorted_processes.begin(), sorted_processes.end(), 
-        [sort_column, sort_ascending](const Process& a, const Process& b) {
-            switch (sort_column) {
-                case 0: // PID
-                    return sort_ascending ? (a.pid < b.pid) : (a.pid > b.pid);
-                case 1: // Name
-                    return sort_ascending ? (a.name < b.name) : (a.name > b.name);
-                case 2: // State
-                    return sort_ascending ? (a.state < b.state) : (a.state > b.state);
-                case 3: // CPU%
-                    return sort_ascending ? (a.cpu_usage < b.cpu_usage) : (a.cpu_usage > b.cpu_usage);
-                case 4: // Memory%
-                    return sort_ascending ? (a.memory_usage < b.memory_usage) : (a.memory_usage > b.memory_usage);
-                default:
-                    return false;
-            }
-        });
+    // Filtered row order; only recomputed for a new snapshot, query or sort key
+    command_lines.prune(*snapshot);
+    static ProcessSortIndex sort_index;
+    sort_index.update(snapshot, (ProcessSortColumn)sort_column, sort_ascending, &process_filter);
     
     // Store selected PIDs
     static set<int> selected_pids;
     
-    // Table rows
-    string filter(filter_text);
+    // Parent/child structure, rebuilt only when a new snapshot arrives
+    static ProcessTree process_tree;
+    process_tree.update(snapshot);
     
-    if (tree_view) {
-        // Tree view - show processes in a hierarchical structure
-        map<int, vector<int>> process_tree = buildProcessTree();
-        map<int, Process> pid_to_process;
-        
-        // Create a map for quick process lookup
-        for (const auto& proc : sorted_processes) {
-            pid_to_process[proc.pid] = proc;
+    // Table rows
+    // Rows on screen this frame, their I/O is read on the next update
+    set<int> frame_visible_pids;
+    auto renderProcessIo = [](const Process& proc) {
+        if (proc.io_sampled) {
+            ImGui::Text("%s", formatSize((unsigned long)proc.io_read_rate).c_str()); ImGui::NextColumn();
+            ImGui::Text("%s", formatSize((unsigned long)proc.io_write_rate).c_str()); ImGui::NextColumn();
+        } else {
+            ImGui::TextDisabled("-"); ImGui::NextColumn();
+            ImGui::TextDisabled("-"); ImGui::NextColumn();
         }
-        
-        // Find root processes (ppid = 0 or 1)
-        vector<int> root_pids;
-        for (const auto& proc : sorted_processes) {
-            if (proc.ppid <= 1) {
-                root_pids.push_back(proc.pid);
-            }
+    };
+    auto renderProcessSmaps = [](const Process& proc) {
+        if (proc.smaps_sampled) {
+            ImGui::Text("%s", formatSize(proc.pss).c_str()); ImGui::NextColumn();
+            ImGui::Text("%s", formatSize(proc.uss).c_str()); ImGui::NextColumn();
+            ImGui::Text("%s", formatSize(proc.swap_pss).c_str()); ImGui::NextColumn();
+        } else {
+            ImGui::TextDisabled("-"); ImGui::NextColumn();
+            ImGui::TextDisabled("-"); ImGui::NextColumn();
+            ImGui::TextDisabled("-"); ImGui::NextColumn();
         }
-        
-        // Helper function to recursively display process tree
-        function<void(int, int)> displayProcessTree = [&](int pid, int depth) {
-            // Skip if process not found
-            if (pid_to_process.find(pid) == pid_to_process.end()) return;
-            
-            const Process& proc = pid_to_process[pid];
+    };
+    
+    if (tree_view) {
+        // Tree view - walk the snapshot's tree in preorder
+        for (int row : process_tree.preorder) {
+            const Process& proc = process_tree.process(row);
             
             // Apply filter if any
-            bool show_process = true;
-            if (!filter.empty()) {
-                show_process = (proc.name.find(filter) != string::npos || 
-                               to_string(proc.pid).find(filter) != string::npos);
+            if (!process_filter.empty() && !process_filter.matches(*snapshot, row)) {
+                continue;
             }
             
-            if (show_process) {
-                // Indent based on depth
-                for (int i = 0; i < depth; i++) {
-                    ImGui::Text("  "); ImGui::SameLine();
-                }
-                
-                // Check if this process is selected
-                bool is_selected = selected_pids.find(proc.pid) != selected_pids.end();
-                
-                // Allow row selection
-                char row_label[32];
-                sprintf(row_label, "%d##%d", proc.pid, proc.pid);
-                
-                // Handle multi-selection with Ctrl key
-                ImGuiSelectableFlags flags = ImGuiSelectableFlags_SpanAllColumns;
-                if (ImGui::Selectable(row_label, is_selected, flags)) {
-                    if (ImGui::GetIO().KeyCtrl) {
-                        // Toggle selection with Ctrl
-                        if (is_selected) selected_pids.erase(proc.pid);
-                        else selected_pids.insert(proc.pid);
-                    } else {
-                        // Single selection without Ctrl
-                        selected_pids.clear();
-                        selected_pids.insert(proc.pid);
-                    }
+            // Indent based on depth
+            float indent = process_tree.depth[row] * 10.0f;
+            if (indent > 0.0f) ImGui::Indent(indent);
+            
+            // Check if this process is selected
+            bool is_selected = selected_pids.find(proc.pid) != selected_pids.end();
+            
+            // Allow row selection
+            char row_label[32];
+            sprintf(row_label, "%d##%d", proc.pid, proc.pid);
+            
+            // Handle multi-selection with Ctrl key
+            ImGuiSelectableFlags flags = ImGuiSelectableFlags_SpanAllColumns;
+            if (ImGui::Selectable(row_label, is_selected, flags)) {
+                if (ImGui::GetIO().KeyCtrl) {
+                    // Toggle selection with Ctrl
+                    if (is_selected) selected_pids.erase(proc.pid);
+                    else selected_pids.insert(proc.pid);
+                } else {
+                    // Single selection without Ctrl
+                    selected_pids.clear();
+                    selected_pids.insert(proc.pid);
                 }
-                
-                ImGui::NextColumn();
-                ImGui::Text("%s", proc.name.c_str()); ImGui::NextColumn();
-                ImGui::Text("%s", proc.getStateString().c_str()); ImGui::NextColumn();
+            }
+            bool visible = ImGui::IsItemVisible();
+            if (visible) frame_visible_pids.insert(proc.pid);
+            if (indent > 0.0f) ImGui::Unindent(indent);
+            
+            // Parents also show the totals of their whole subtree
+            ImGui::NextColumn();
+            ImGui::Text("%s", proc.name.c_str()); ImGui::NextColumn();
+            ImGui::Text("%s", user_names.name(proc.uid).c_str()); ImGui::NextColumn();
+            ImGui::Text("%s", proc.getStateString().c_str()); ImGui::NextColumn();
+            if (process_tree.childCount(row) > 0) {
+                ImGui::Text("%.1f (%.1f)", proc.cpu_usage, process_tree.subtree_cpu[row]); ImGui::NextColumn();
+                ImGui::Text("%.1f (%.1f)", proc.memory_usage, process_tree.subtree_memory[row]); ImGui::NextColumn();
+            } else {
                 ImGui::Text("%.1f", proc.cpu_usage); ImGui::NextColumn();
                 ImGui::Text("%.1f", proc.memory_usage); ImGui::NextColumn();
             }
-            
-            // Recursively display children
-            if (process_tree.find(pid) != process_tree.end()) {
-                for (int child_pid : process_tree[pid]) {
-                    displayProcessTree(child_pid, depth + 1);
-                }
+            if (show_io) {
+                renderProcessIo(proc);
             }
-        };
-        
-        // Display the tree starting from root processes
-        for (int root_pid : root_pids) {
-            displayProcessTree(root_pid, 0);
+            if (show_smaps) {
+                renderProcessSmaps(proc);
+            }
+            // The tree isn't clipped; only rows on screen read their command line
+            ImGui::Text("%s", visible ? command_lines.get(proc).c_str() : ""); ImGui::NextColumn();
         }
     } else {
         // Flat view - show all processes in a list
-        for (const auto& proc : sorted_processes) {
-            // Apply filter if any
-            if (!filter.empty() && 
-                proc.name.find(filter) == string::npos && 
-                to_string(proc.pid).find(filter) == string::npos) {
-                continue;
-            }
-            
+        auto renderFlatRow = [&](const Process& proc) {
             // Check if this process is selected
             bool is_selected = selected_pids.find(proc.pid) != selected_pids.end();
             
@@ -555,44 +1022,128 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
                     selected_pids.insert(proc.pid);
                 }
             }
+            if (ImGui::IsItemVisible()) frame_visible_pids.insert(proc.pid);
             
             ImGui::NextColumn();
             ImGui::Text("%s", proc.name.c_str()); ImGui::NextColumn();
+            ImGui::Text("%s", user_names.name(proc.uid).c_str()); ImGui::NextColumn();
             ImGui::Text("%s", proc.getStateString().c_str()); ImGui::NextColumn();
             ImGui::Text("%.1f", proc.cpu_usage); ImGui::NextColumn();
             ImGui::Text("%.1f", proc.memory_usage); ImGui::NextColumn();
+            if (show_io) {
+                renderProcessIo(proc);
+            }
+            if (show_smaps) {
+                renderProcessSmaps(proc);
+            }
+            ImGui::Text("%s", command_lines.get(proc).c_str()); ImGui::NextColumn();
+        };
+        
+        // Only the rows on screen are drawn, and only as much of the
+        // order as they need is sorted
+        ImGuiListClipper clipper;
+        clipper.Begin((int)sort_index.size());
+        while (clipper.Step()) {
+            sort_index.sortedPrefix(clipper.DisplayEnd);
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                renderFlatRow(sort_index.process(i));
+            }
         }
     }
     
     ImGui::Columns(1);
     ImGui::EndChild();
+    visible_pids.swap(frame_visible_pids);
     
     // Process view options
     ImGui::Checkbox("Tree View", &tree_view);
+    ImGui::SameLine();
+    if (ImGui::Checkbox("I/O", &show_io) && show_io) {
+        g_processTable.requestSample();   // Fill the columns right away
+    }
+    if (show_io) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100);
+        ImGui::SliderInt("Top-N I/O", &io_top_n, 0, 200);
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("PSS", &show_smaps);
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Proportional (PSS), private (USS) and swapped memory from smaps_rollup,\n"
+                          "shared pages split between the processes mapping them");
+    }
+    if (show_smaps) {
+        const SmapsSampler& smaps = g_processTable.memoryAccounting();
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100);
+        ImGui::SliderFloat("CPU budget", &smaps_budget_percent, 0.5f, 20.0f, "%.1f%%");
+        ImGui::SameLine();
+        ImGui::TextDisabled("(pass %.1fs, %.1f%% CPU)", smaps.lastPassSeconds(), smaps.cpuUsage() * 100.0f);
+    }
     
     ImGui::SameLine();
     
     // Process actions
     if (ImGui::Button("Refresh")) {
-        processes = getAllProcesses();
-        updateProcessCpuUsage(processes);
-        last_update_time = current_time;
+        g_processTable.requestSample();
     }
     
     ImGui::SameLine();
     
+    // Batched signal actions, run on a worker and reported per pid
+    static ProcessActionRunner actions;
+    static int action_signal = 0;
+    static int sent_signal = 0;
+    static int action_scope = 0;     // 0=selection, 1=selection and subtrees, 2=cgroups of selection
+    static vector<ProcessActionResult> action_results;
+    static string action_summary;
+    
     if (!selected_pids.empty()) {
-        if (ImGui::Button("Kill Selected Process(es)")) {
-            for (int pid : selected_pids) {
-                if (killProcess(pid)) {
-                    // Process killed successfully
-                } else {
-                    // Failed to kill process
+        ImGui::SetNextItemWidth(100);
+        if (ImGui::BeginCombo("##signal", ACTION_SIGNALS[action_signal].name)) {
+            for (int i = 0; i < IM_ARRAYSIZE(ACTION_SIGNALS); i++) {
+                if (ImGui::Selectable(ACTION_SIGNALS[i].name, i == action_signal)) action_signal = i;
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(140);
+        ImGui::Combo("##scope", &action_scope, "Selection\0With subtrees\0Whole cgroups\0");
+        ImGui::SameLine();
+        
+        if (ImGui::Button("Send")) {
+            int signal = ACTION_SIGNALS[action_signal].number;
+            sent_signal = action_signal;
+            action_results.clear();
+            action_summary = string(ACTION_SIGNALS[action_signal].name) + ": waiting for results";
+            
+            if (action_scope == 2) {
+                // Never signal the root group, that is every process on the system
+                set<string> groups;
+                for (int pid : selected_pids) {
+                    string group = ProcessActionRunner::cgroupOf(pid, g_cgroups.rootPath());
+                    if (!group.empty() && group != g_cgroups.rootPath()) groups.insert(group);
                 }
+                for (const auto& group : groups) actions.submitCgroup(signal, group);
+                if (groups.empty()) action_summary = "No non-root cgroup to signal";
+            } else {
+                vector<int> rows;
+                for (int pid : selected_pids) {
+                    int row = process_tree.find(pid);
+                    if (row < 0) continue;
+                    if (action_scope == 1) process_tree.subtree(row, rows);
+                    else rows.push_back(row);
+                }
+                sort(rows.begin(), rows.end());
+                rows.erase(unique(rows.begin(), rows.end()), rows.end());
+                
+                vector<ProcessActionTarget> targets;
+                for (int row : rows) {
+                    const Process& proc = process_tree.process(row);
+                    targets.push_back({proc.pid, proc.start_time, proc.name});
+                }
+                actions.submit(signal, targets);
             }
-            // Refresh process list immediately after kill
-            processes = getAllProcesses();
-            updateProcessCpuUsage(processes);
             selected_pids.clear();
         }
         
@@ -605,59 +1156,146 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
         }
     }
     
-    // Process alerts
-    if (!selected_pids.empty() && selected_pids.size() == 1) {
-        ImGui::SameLine();
-        if (ImGui::Button("Add Alert")) {
-            ImGui::OpenPopup("Add Process Alert");
+    // Patch the finished pids into the table instead of rescanning
+    vector<ProcessActionResult> new_results;
+    actions.collect(new_results);
+    if (!new_results.empty()) {
+        vector<int> changed;
+        for (const auto& result : new_results) changed.push_back(result.pid);
+        g_processTable.patch(changed);
+        action_results.insert(action_results.end(), new_results.begin(), new_results.end());
+        
+        int delivered = 0, exited = 0, failed = 0;
+        for (const auto& result : action_results) {
+            if (result.error) failed++;
+            else delivered++;
+            if (result.exited) exited++;
+        }
+        char summary[128];
+        snprintf(summary, sizeof(summary), "%s: %d delivered, %d exited, %d failed%s",
+                 ACTION_SIGNALS[sent_signal].name, delivered, exited, failed, actions.busy() ? " (running)" : "");
+        action_summary = summary;
+    }
+    if (!action_summary.empty()) {
+        ImGui::Text("%s", action_summary.c_str());
+        if (!action_results.empty()) {
+            ImGui::SameLine();
+            if (ImGui::TreeNode("Results")) {
+                for (const auto& result : action_results) {
+                    ImGui::Text("%d %s: %s%s", result.pid, result.name.c_str(),
+                                result.error ? strerror(result.error) : "delivered", result.exited ? ", exited" : "");
+                }
+                ImGui::TreePop();
+            }
         }
     }
     
-    // Add process alert popup
-    if (ImGui::BeginPopup("Add Process Alert")) {
-        static float cpu_threshold = 50.0f;
-        static float memory_threshold = 50.0f;
-        
+    // Process alert rules, evaluated by the sampler thread
+    static vector<ProcessAlertRule> alert_rules;
+    static int next_rule_id = 1;
+    static string alert_error;
+    static char alert_pattern[128] = "";
+    static int alert_field = ALERT_MATCH_NAME;
+    static int alert_metric = ALERT_METRIC_CPU;
+    static float alert_raise = 50.0f;
+    static float alert_clear = 40.0f;
+    static float alert_sustain = 5.0f;
+    
+    ImGui::SameLine();
+    if (ImGui::Button("Add Alert")) {
+        // Start from the selected process's exact name
         if (selected_pids.size() == 1) {
-            int pid = *selected_pids.begin();
-            string name;
-            
-            // Find the selected process name
-            for (const auto& p : processes) {
-                if (p.pid == pid) {
-                    name = p.name;
-                    break;
+            int row = process_tree.find(*selected_pids.begin());
+            if (row >= 0) {
+                string escaped = "^";
+                for (char c : process_tree.process(row).name) {
+                    if (strchr("\\^$.|?*+()[]{}", c)) escaped += '\\';
+                    escaped += c;
                 }
+                escaped += "$";
+                snprintf(alert_pattern, sizeof(alert_pattern), "%s", escaped.c_str());
+                alert_field = ALERT_MATCH_NAME;
             }
-            
-            ImGui::Text("Add Alert for Process: %s (PID: %d)", name.c_str(), pid);
-            ImGui::Separator();
-            
-            ImGui::SliderFloat("CPU Threshold (%)", &cpu_threshold, 0.0f, 100.0f);
-            ImGui::SliderFloat("Memory Threshold (%)", &memory_threshold, 0.0f, 100.0f);
-            
-            if (ImGui::Button("Add Alert")) {
-                // Check if alert already exists for this PID
-                bool exists = false;
-                for (auto& alert : g_process_alerts) {
-                    if (alert.pid == pid) {
-                        alert.cpu_threshold = cpu_threshold;
-                        alert.memory_threshold = memory_threshold;
-                        exists = true;
-                        break;
-                    }
-                }
-                
-                if (!exists) {
-                    g_process_alerts.emplace_back(pid, name, cpu_threshold, memory_threshold);
-                }
-                
+        }
+        ImGui::OpenPopup("Add Process Alert");
+    }
+    
+    // Add process alert popup
+    if (ImGui::BeginPopup("Add Process Alert")) {
+        ImGui::Text("Alert on every process matching:");
+        ImGui::Separator();
+        
+        ImGui::Combo("Match", &alert_field, "Name\0Command line\0Cgroup\0");
+        ImGui::InputText("Pattern (regex)", alert_pattern, IM_ARRAYSIZE(alert_pattern));
+        ImGui::Combo("Metric", &alert_metric, "CPU%\0Memory%\0");
+        ImGui::SliderFloat("Raise above (%)", &alert_raise, 0.0f, 100.0f);
+        ImGui::SliderFloat("Clear at or below (%)", &alert_clear, 0.0f, 100.0f);
+        ImGui::SliderFloat("Sustained for (s)", &alert_sustain, 0.0f, 300.0f);
+        if (alert_clear > alert_raise) alert_clear = alert_raise;
+        
+        if (ImGui::Button("Add Alert")) {
+            ProcessAlertRule rule = {next_rule_id, (AlertMatchField)alert_field, alert_pattern,
+                                     (AlertMetric)alert_metric, alert_raise, alert_clear, alert_sustain};
+            vector<ProcessAlertRule> updated = alert_rules;
+            updated.push_back(rule);
+            if (g_processAlerts.setRules(updated, alert_error)) {
+                alert_rules.swap(updated);
+                next_rule_id++;
                 ImGui::CloseCurrentPopup();
             }
         }
+        if (!alert_error.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", alert_error.c_str());
+        }
         ImGui::EndPopup();
     }
     
+    if (!alert_rules.empty() && ImGui::TreeNode("Alert Rules")) {
+        static const char* FIELD_NAMES[] = {"name", "cmdline", "cgroup"};
+        for (size_t i = 0; i < alert_rules.size(); i++) {
+            const ProcessAlertRule& rule = alert_rules[i];
+            ImGui::Text("#%d %s ~ /%s/: %s > %.1f for %.0fs, clears at %.1f", rule.id, FIELD_NAMES[rule.field],
+                        rule.pattern.c_str(), ProcessAlertEngine::metricName(rule.metric), rule.raise_threshold,
+                        rule.sustain_seconds, rule.clear_threshold);
+            ImGui::SameLine();
+            ImGui::PushID(rule.id);
+            if (ImGui::SmallButton("Remove")) {
+                vector<ProcessAlertRule> updated = alert_rules;
+                updated.erase(updated.begin() + i);
+                if (g_processAlerts.setRules(updated, alert_error)) alert_rules.swap(updated);
+                ImGui::PopID();
+                break;
+            }
+            ImGui::PopID();
+        }
+        
+        // Optional log sink
+        static char log_path[256] = "";
+        static bool logging = false;
+        static string log_error;
+        ImGui::SetNextItemWidth(250);
+        ImGui::InputText("##alertlog", log_path, IM_ARRAYSIZE(log_path));
+        ImGui::SameLine();
+        if (ImGui::Checkbox("Log to file", &logging)) {
+            if (!g_processAlerts.setLogFile(logging ? log_path : "", log_error)) logging = false;
+        }
+        if (!log_error.empty()) {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", log_error.c_str());
+        }
+        
+        ImGui::Text("Recent events (%lu dropped):", g_processAlerts.droppedEvents());
+        for (const auto& event : alert_history) {
+            char stamp[16];
+            struct tm local;
+            localtime_r(&event.time, &local);
+            strftime(stamp, sizeof(stamp), "%H:%M:%S", &local);
+            ImGui::Text("%s %s #%d %s (PID %d) %.1f", stamp, event.raised ? "raised " : "cleared",
+                        event.rule_id, event.process_name.c_str(), event.pid, event.value);
+        }
+        ImGui::TreePop();
+    }
+    
     // Process details popup
     if (ImGui::BeginPopup("Process Details")) {
         if (selected_pids.size() == 1) {
@@ -676,6 +1314,12 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
             ImGui::Separator();
             ImGui::Text("PID: %d", proc.pid);
             ImGui::Text("Name: %s", proc.name.c_str());
+            ImGui::Text("User: %s (%d)", user_names.name(proc.uid).c_str(), (int)proc.uid);
+            if (!proc.name.empty()) {
+                ImGui::PushTextWrapPos(ImGui::GetFontSize() * 40.0f);
+                ImGui::TextWrapped("Command: %s", command_lines.get(proc).c_str());
+                ImGui::PopTextWrapPos();
+            }
             ImGui::Text("State: %s", proc.getStateString().c_str());
             ImGui::Text("Parent PID: %d", proc.ppid);
             ImGui::Text("Priority: %d", proc.priority);
@@ -699,12 +1343,78 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
             
             ImGui::Separator();
             
+            // Threads, sampled at a high rate only while this popup is open
+            static ThreadSampler thread_sampler;
+            static float thread_interval = 0.25f;
+            static float last_thread_time = -1.0f;
+            if (thread_sampler.pid() != pid) {
+                thread_sampler.setPid(pid);
+                last_thread_time = -1.0f;
+            }
+            if (last_thread_time < 0.0f || ImGui::GetTime() - last_thread_time >= thread_interval) {
+                thread_sampler.sample();
+                last_thread_time = ImGui::GetTime();
+            }
+            
+            const vector<ThreadInfo>& threads = thread_sampler.threads();
+            ImGui::Text("Threads: %d", (int)threads.size());
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(120);
+            ImGui::SliderFloat("Refresh (s)##threads", &thread_interval, 0.1f, 2.0f, "%.2f");
+            
+            if (ImGui::BeginTable("Threads", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                                  ImVec2(500, 200))) {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("TID");
+                ImGui::TableSetupColumn("Name");
+                ImGui::TableSetupColumn("State");
+                ImGui::TableSetupColumn("CPU%");
+                ImGui::TableSetupColumn("Processor");
+                ImGui::TableSetupColumn("Nice");
+                ImGui::TableHeadersRow();
+                
+                // Busiest threads first
+                static vector<int> thread_order;
+                thread_order.resize(threads.size());
+                for (size_t i = 0; i < threads.size(); i++) thread_order[i] = (int)i;
+                sort(thread_order.begin(), thread_order.end(), [&threads](int a, int b) {
+                    return threads[a].cpu_usage > threads[b].cpu_usage;
+                });
+                
+                ImGuiListClipper clipper;
+                clipper.Begin((int)thread_order.size());
+                while (clipper.Step()) {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                        const ThreadInfo& thread_info = threads[thread_order[row]];
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::Text("%d", thread_info.tid);
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::TextUnformatted(thread_info.name);
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::Text("%c", thread_info.state);
+                        ImGui::TableSetColumnIndex(3);
+                        ImGui::Text("%.1f", thread_info.cpu_usage);
+                        ImGui::TableSetColumnIndex(4);
+                        ImGui::Text("%d", thread_info.processor);
+                        ImGui::TableSetColumnIndex(5);
+                        ImGui::Text("%d", thread_info.nice);
+                    }
+                }
+                
+                ImGui::EndTable();
+            }
+            
+            ImGui::Separator();
+            
             // Child processes
-            vector<Process> children = getProcessChildren(pid);
-            if (!children.empty()) {
-                ImGui::Text("Child Processes:");
-                for (const auto& child : children) {
-                    ImGui::Text("PID: %d, Name: %s", child.pid, child.name.c_str());
+            int row = process_tree.find(pid);
+            if (row >= 0 && process_tree.childCount(row) > 0) {
+                ImGui::Text("Child Processes: (subtree of %d: %.1f%% CPU, %.1f%% memory)",
+                            process_tree.subtree_size[row], process_tree.subtree_cpu[row], process_tree.subtree_memory[row]);
+                for (const int* child = process_tree.childrenBegin(row); child != process_tree.childrenEnd(row); ++child) {
+                    const Process& child_proc = process_tree.process(*child);
+                    ImGui::Text("PID: %d, Name: %s", child_proc.pid, child_proc.name.c_str());
                 }
             } else {
                 ImGui::Text("No child processes");
@@ -729,30 +1439,41 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
     
     // Get all network interfaces
     static vector<NetworkInterface> interfaces;
+    static unsigned long interfaces_generation = 0;
     static float last_update_time = 0.0f;
     float current_time = ImGui::GetTime();
     
-    // Update network interfaces every 5 seconds
-    if (current_time - last_update_time >= 5.0f || interfaces.empty()) {
+    if (g_netlinkAvailable) {
+        // Event driven: only copy the table when netlink reported a change
+        if (g_netlinkMonitor.generation() != interfaces_generation) {
+            interfaces_generation = g_netlinkMonitor.snapshot(interfaces);
+        }
+    } else if (current_time - last_update_time >= 5.0f || interfaces.empty()) {
+        // Fallback: update network interfaces every 5 seconds
         interfaces = getNetworkInterfaces();
         last_update_time = current_time;
     }
     
     // Refresh button
     if (ImGui::Button("Refresh")) {
-        interfaces = getNetworkInterfaces();
-        last_update_time = current_time;
+        if (g_netlinkAvailable) {
+            g_netlinkMonitor.requestResync();
+        } else {
+            interfaces = getNetworkInterfaces();
+            last_update_time = current_time;
+        }
     }
     
     ImGui::Spacing();
     
     // Display interfaces in a table
-    if (ImGui::BeginTable("NetworkInterfaces", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+    if (ImGui::BeginTable("NetworkInterfaces", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
         // Table headers
         ImGui::TableSetupColumn("Interface");
         ImGui::TableSetupColumn("Type");
         ImGui::TableSetupColumn("Status");
         ImGui::TableSetupColumn("IPv4 Address");
+        ImGui::TableSetupColumn("IPv6 Address");
         ImGui::TableSetupColumn("MAC Address");
         ImGui::TableHeadersRow();
         
@@ -784,8 +1505,12 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
             ImGui::TableSetColumnIndex(3);
             ImGui::Text("%s", interface.ipv4_address.c_str());
             
-            // MAC address
+            // IPv6 address
             ImGui::TableSetColumnIndex(4);
+            ImGui::Text("%s", interface.ipv6_address.c_str());
+            
+            // MAC address
+            ImGui::TableSetColumnIndex(5);
             ImGui::Text("%s", interface.mac_address.c_str());
         }
         
@@ -890,7 +1615,7 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
             }
             
             // Update network graphs
-            updateNetworkGraph(g_rxGraph, g_txGraph, selected_interface);
+            updateNetworkGraph(g_netRegistry, g_rxGraph, g_txGraph, selected_interface);
             
             // Plot the RX graph
             ImGui::PlotLines("##rxgraph", g_rxGraph.values, NetworkGraph::MAX_VALUES, 
@@ -914,48 +1639,381 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
             // Get active connections
             static vector<NetworkConnection> connections;
             static float last_conn_update = 0.0f;
+            static bool connections_dirty = true;
+            
+            // Grouping: 0 = none, otherwise ConnectionGroupBy + 1
+            static int group_mode = 0;
+            static ConnectionAggregator aggregator;
+            static vector<ConnectionGroup> groups;
+            static uint64_t selected_group_key = 0;
+            static bool group_selected = false;
+            static vector<int> drill_rows;
+            static bool drill_dirty = false;
             
             // Update connections every 3 seconds
-            if (current_time - last_conn_update >= 3.0f || connections.empty()) {
-                connections = getActiveConnections();
-                last_conn_update = current_time;
-            }
+            bool refresh = current_time - last_conn_update >= 3.0f || connections.empty();
             
             // Refresh button
             if (ImGui::Button("Refresh Connections")) {
+                refresh = true;
+            }
+            
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(160);
+            const char* group_modes[] = {"None", "Remote IP", "Remote Port", "Local Port", "State", "Process"};
+            if (ImGui::Combo("Group by", &group_mode, group_modes, IM_ARRAYSIZE(group_modes))) {
+                group_selected = false;
+                connections_dirty = true;
+                // Owners are only resolved when grouping by process needs them
+                if (group_mode - 1 == GROUP_BY_PROCESS) {
+                    assignConnectionOwners(connections);
+                }
+            }
+            
+            if (refresh) {
                 connections = getActiveConnections();
+                if (group_mode - 1 == GROUP_BY_PROCESS) {
+                    assignConnectionOwners(connections);
+                }
                 last_conn_update = current_time;
+                connections_dirty = true;
             }
             
+            ConnectionGroupBy group_by = (ConnectionGroupBy)(group_mode - 1);
+            if (connections_dirty && group_mode > 0) {
+                aggregator.aggregate(connections, group_by, groups);
+                sort(groups.begin(), groups.end(), [](const ConnectionGroup& a, const ConnectionGroup& b) {
+                    return a.count > b.count;
+                });
+            }
+            if ((connections_dirty || drill_dirty) && group_selected) {
+                // Rows of the selected group for drill-down
+                drill_rows.clear();
+                for (int i = 0; i < (int)connections.size(); i++) {
+                    if (ConnectionAggregator::groupKey(connections[i], group_by) == selected_group_key) {
+                        drill_rows.push_back(i);
+                    }
+                }
+            }
+            connections_dirty = false;
+            drill_dirty = false;
+            
+            ImGui::Text("%d connections", (int)connections.size());
+            if (group_mode > 0) {
+                ImGui::SameLine();
+                ImGui::Text("in %d groups", (int)groups.size());
+            }
             ImGui::Spacing();
             
-            // Display connections in a table
-            if (ImGui::BeginTable("Connections", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+            // Draws one connection row into the current table
+            auto drawConnectionRow = [](const NetworkConnection& conn) {
+                ImGui::TableNextRow();
+                
+                ImGui::TableSetColumnIndex(0);
+                ImGui::Text("%s", conn.protocol.c_str());
+                
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%s", conn.local_address.c_str());
+                
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%s", conn.remote_address.c_str());
+                
+                ImGui::TableSetColumnIndex(3);
+                if (conn.state_code == 1) {
+                    ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "%s", conn.state.c_str());
+                } else if (conn.state_code == 10) {
+                    ImGui::TextColored(ImVec4(0.0f, 0.0f, 1.0f, 1.0f), "%s", conn.state.c_str());
+                } else {
+                    ImGui::Text("%s", conn.state.c_str());
+                }
+                
+                ImGui::TableSetColumnIndex(4);
+                ImGui::Text("%u", conn.tx_queue);
+                
+                ImGui::TableSetColumnIndex(5);
+                ImGui::Text("%u", conn.rx_queue);
+            };
+            
+            auto setupConnectionColumns = []() {
+                ImGui::TableSetupScrollFreeze(0, 1);
                 ImGui::TableSetupColumn("Protocol");
                 ImGui::TableSetupColumn("Local Address");
                 ImGui::TableSetupColumn("Remote Address");
                 ImGui::TableSetupColumn("State");
+                ImGui::TableSetupColumn("Send-Q");
+                ImGui::TableSetupColumn("Recv-Q");
                 ImGui::TableHeadersRow();
-                
-                for (const auto& conn : connections) {
-                    ImGui::TableNextRow();
+            };
+            
+            ImGuiTableFlags table_flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+            
+            if (group_mode == 0) {
+                // Display connections in a table, only the visible rows are submitted
+                if (ImGui::BeginTable("Connections", 6, table_flags)) {
+                    setupConnectionColumns();
                     
-                    ImGui::TableSetColumnIndex(0);
-                    ImGui::Text("%s", conn.protocol.c_str());
+                    ImGuiListClipper clipper;
+                    clipper.Begin((int)connections.size());
+                    while (clipper.Step()) {
+                        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                            drawConnectionRow(connections[row]);
+                        }
+                    }
                     
-                    ImGui::TableSetColumnIndex(1);
-                    ImGui::Text("%s", conn.local_address.c_str());
+                    ImGui::EndTable();
+                }
+            } else {
+                // Aggregated groups, click a group to drill down
+                float groups_height = group_selected ? ImGui::GetContentRegionAvail().y * 0.5f : 0.0f;
+                if (ImGui::BeginTable("ConnectionGroups", 4, table_flags, ImVec2(0, groups_height))) {
+                    ImGui::TableSetupScrollFreeze(0, 1);
+                    ImGui::TableSetupColumn(group_modes[group_mode]);
+                    ImGui::TableSetupColumn("Connections");
+                    ImGui::TableSetupColumn("Send-Q Total");
+                    ImGui::TableSetupColumn("Recv-Q Total");
+                    ImGui::TableHeadersRow();
                     
-                    ImGui::TableSetColumnIndex(2);
-                    ImGui::Text("%s", conn.remote_address.c_str());
+                    ImGuiListClipper clipper;
+                    clipper.Begin((int)groups.size());
+                    while (clipper.Step()) {
+                        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                            const ConnectionGroup& group = groups[row];
+                            ImGui::TableNextRow();
+                            
+                            ImGui::TableSetColumnIndex(0);
+                            bool is_selected = group_selected && group.key == selected_group_key;
+                            ImGui::PushID(row);
+                            if (ImGui::Selectable(group.label.c_str(), is_selected, ImGuiSelectableFlags_SpanAllColumns)) {
+                                group_selected = !is_selected;
+                                selected_group_key = group.key;
+                                drill_dirty = true; // Rebuild drill-down rows next frame
+                            }
+                            ImGui::PopID();
+                            
+                            ImGui::TableSetColumnIndex(1);
+                            ImGui::Text("%d", group.count);
+                            ImGui::TableSetColumnIndex(2);
+                            ImGui::Text("%llu", group.tx_queue);
+                            ImGui::TableSetColumnIndex(3);
+                            ImGui::Text("%llu", group.rx_queue);
+                        }
+                    }
                     
-                    ImGui::TableSetColumnIndex(3);
-                    if (conn.state == "ESTABLISHED") {
-                        ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "%s", conn.state.c_str());
-                    } else if (conn.state == "LISTEN") {
-                        ImGui::TextColored(ImVec4(0.0f, 0.0f, 1.0f, 1.0f), "%s", conn.state.c_str());
+                    ImGui::EndTable();
+                }
+                
+                if (group_selected) {
+                    ImGui::Text("Connections in %s (%d)", ConnectionAggregator::groupLabel(selected_group_key, group_by).c_str(),
+                                (int)drill_rows.size());
+                    if (ImGui::BeginTable("ConnectionDrillDown", 6, table_flags)) {
+                        setupConnectionColumns();
+                        
+                        ImGuiListClipper clipper;
+                        clipper.Begin((int)drill_rows.size());
+                        while (clipper.Step()) {
+                            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                                drawConnectionRow(connections[drill_rows[row]]);
+                            }
+                        }
+                        
+                        ImGui::EndTable();
+                    }
+                }
+            }
+            
+            ImGui::EndTabItem();
+        }
+        
+        // TCP Performance Tab
+        if (ImGui::BeginTabItem("TCP Performance")) {
+            ImGui::Text("Per-connection TCP metrics (tcp_info)");
+            
+            // Get tcp_info for every connection
+            static vector<TcpConnectionMetrics> tcp_metrics;
+            static vector<TcpConnectionMetrics> tcp_view; // Sorted (and possibly truncated) rows
+            static float last_metrics_update = -10.0f;
+            static bool metrics_dirty = true;
+            
+            // Update metrics every 2 seconds
+            if (current_time - last_metrics_update >= 2.0f) {
+                tcp_metrics = getTcpConnectionMetrics();
+                last_metrics_update = current_time;
+                metrics_dirty = true;
+            }
+            
+            // Top-N by retransmits
+            static bool top_retransmits = false;
+            static int top_n = 20;
+            if (ImGui::Checkbox("Top N by retransmits", &top_retransmits)) {
+                metrics_dirty = true;
+            }
+            if (top_retransmits) {
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(120);
+                if (ImGui::SliderInt("N##tcptop", &top_n, 5, 100)) {
+                    metrics_dirty = true;
+                }
+            }
+            
+            ImGui::Spacing();
+            
+            ImGuiTableFlags table_flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY |
+                                          ImGuiTableFlags_Sortable | ImGuiTableFlags_Resizable;
+            if (ImGui::BeginTable("TcpPerformance", 12, table_flags)) {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("Local Address");
+                ImGui::TableSetupColumn("Remote Address");
+                ImGui::TableSetupColumn("State");
+                ImGui::TableSetupColumn("SRTT ms");
+                ImGui::TableSetupColumn("RTTVar ms");
+                ImGui::TableSetupColumn("Cwnd");
+                ImGui::TableSetupColumn("Retrans", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+                ImGui::TableSetupColumn("Bytes Acked");
+                ImGui::TableSetupColumn("Bytes Recv");
+                ImGui::TableSetupColumn("Delivery Rate");
+                ImGui::TableSetupColumn("Send-Q");
+                ImGui::TableSetupColumn("Recv-Q");
+                ImGui::TableHeadersRow();
+                
+                // Re-sort only when the data or the sort specs changed
+                ImGuiTableSortSpecs* sort_specs = ImGui::TableGetSortSpecs();
+                if (sort_specs && (sort_specs->SpecsDirty || metrics_dirty)) {
+                    int column = sort_specs->SpecsCount > 0 ? sort_specs->Specs[0].ColumnIndex : 6;
+                    bool ascending = sort_specs->SpecsCount > 0 && sort_specs->Specs[0].SortDirection == ImGuiSortDirection_Ascending;
+                    auto key_less = [column](const TcpConnectionMetrics& a, const TcpConnectionMetrics& b) {
+                        switch (column) {
+                            case 0: return a.local_address < b.local_address;
+                            case 1: return a.remote_address < b.remote_address;
+                            case 2: return a.state < b.state;
+                            case 3: return a.srtt_ms < b.srtt_ms;
+                            case 4: return a.rttvar_ms < b.rttvar_ms;
+                            case 5: return a.snd_cwnd < b.snd_cwnd;
+                            case 6: return a.total_retrans < b.total_retrans;
+                            case 7: return a.bytes_acked < b.bytes_acked;
+                            case 8: return a.bytes_received < b.bytes_received;
+                            case 9: return a.delivery_rate < b.delivery_rate;
+                            case 10: return a.send_queue < b.send_queue;
+                            case 11: return a.recv_queue < b.recv_queue;
+                            default: return false;
+                        }
+                    };
+                    
+                    tcp_view = tcp_metrics;
+                    if (top_retransmits) {
+                        // Keep only the worst N connections by total retransmits
+                        size_t n = min((size_t)top_n, tcp_view.size());
+                        partial_sort(tcp_view.begin(), tcp_view.begin() + n, tcp_view.end(),
+                            [](const TcpConnectionMetrics& a, const TcpConnectionMetrics& b) {
+                                return a.total_retrans > b.total_retrans;
+                            });
+                        tcp_view.resize(n);
+                    }
+                    
+                    if (ascending) {
+                        stable_sort(tcp_view.begin(), tcp_view.end(), key_less);
                     } else {
+                        stable_sort(tcp_view.begin(), tcp_view.end(),
+                            [&key_less](const TcpConnectionMetrics& a, const TcpConnectionMetrics& b) { return key_less(b, a); });
+                    }
+                    
+                    sort_specs->SpecsDirty = false;
+                    metrics_dirty = false;
+                }
+                
+                // Only submit the visible rows
+                ImGuiListClipper clipper;
+                clipper.Begin((int)tcp_view.size());
+                while (clipper.Step()) {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                        const TcpConnectionMetrics& conn = tcp_view[row];
+                        ImGui::TableNextRow();
+                        
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::Text("%s", conn.local_address.c_str());
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::Text("%s", conn.remote_address.c_str());
+                        ImGui::TableSetColumnIndex(2);
                         ImGui::Text("%s", conn.state.c_str());
+                        ImGui::TableSetColumnIndex(3);
+                        ImGui::Text("%.2f", conn.srtt_ms);
+                        ImGui::TableSetColumnIndex(4);
+                        ImGui::Text("%.2f", conn.rttvar_ms);
+                        ImGui::TableSetColumnIndex(5);
+                        ImGui::Text("%u", conn.snd_cwnd);
+                        ImGui::TableSetColumnIndex(6);
+                        if (conn.total_retrans > 0) {
+                            ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "%u", conn.total_retrans);
+                        } else {
+                            ImGui::Text("%u", conn.total_retrans);
+                        }
+                        ImGui::TableSetColumnIndex(7);
+                        ImGui::Text("%s", formatSize(conn.bytes_acked).c_str());
+                        ImGui::TableSetColumnIndex(8);
+                        ImGui::Text("%s", formatSize(conn.bytes_received).c_str());
+                        ImGui::TableSetColumnIndex(9);
+                        ImGui::Text("%s/s", formatSize(conn.delivery_rate).c_str());
+                        ImGui::TableSetColumnIndex(10);
+                        ImGui::Text("%u", conn.send_queue);
+                        ImGui::TableSetColumnIndex(11);
+                        ImGui::Text("%u", conn.recv_queue);
+                    }
+                }
+                
+                ImGui::EndTable();
+            }
+            
+            ImGui::EndTabItem();
+        }
+        
+        // Per-process traffic Tab
+        if (ImGui::BeginTabItem("Top Talkers")) {
+            ImGui::Text("Per-process TCP throughput");
+            
+            // Accounting scans every process's fds, so it only runs while enabled
+            bool accounting = g_netAccounting.isRunning();
+            if (ImGui::Checkbox("Enable per-process accounting", &accounting)) {
+                if (accounting) g_netAccounting.start();
+                else g_netAccounting.stop();
+            }
+            
+            static vector<ProcessTraffic> talkers;
+            static float last_talkers_update = 0.0f;
+            if (current_time - last_talkers_update >= 1.0f) {
+                talkers = g_netAccounting.topTalkers();
+                last_talkers_update = current_time;
+            }
+            
+            ImGui::Spacing();
+            
+            if (ImGui::BeginTable("TopTalkers", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("PID");
+                ImGui::TableSetupColumn("Process");
+                ImGui::TableSetupColumn("Sockets");
+                ImGui::TableSetupColumn("TX/s");
+                ImGui::TableSetupColumn("RX/s");
+                ImGui::TableSetupColumn("Total (interval)");
+                ImGui::TableHeadersRow();
+                
+                ImGuiListClipper clipper;
+                clipper.Begin((int)talkers.size());
+                while (clipper.Step()) {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                        const ProcessTraffic& traffic = talkers[row];
+                        ImGui::TableNextRow();
+                        
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::Text("%d", traffic.pid);
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::Text("%s", traffic.process_name.c_str());
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::Text("%d", traffic.sockets);
+                        ImGui::TableSetColumnIndex(3);
+                        ImGui::Text("%s/s", formatSize((unsigned long)traffic.tx_rate).c_str());
+                        ImGui::TableSetColumnIndex(4);
+                        ImGui::Text("%s/s", formatSize((unsigned long)traffic.rx_rate).c_str());
+                        ImGui::TableSetColumnIndex(5);
+                        ImGui::Text("%s", formatSize(traffic.tx_bytes + traffic.rx_bytes).c_str());
                     }
                 }
                 
@@ -1023,9 +2081,105 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
     ImGui::End();
 }
 
+static void startExporter(const string& address, int port) {
+    string exporter_error;
+    if (g_exporter.start(address, port, &g_systemSampler, &g_processTable, exporter_error)) {
+        fprintf(stderr, "Serving metrics on http://%s:%d/metrics\n", address.c_str(), port);
+    } else {
+        fprintf(stderr, "Metrics exporter: %s\n", exporter_error.c_str());
+    }
+}
+
+struct HeadlessOptions {
+    StreamFormat format = STREAM_NDJSON;
+    string output = "-";
+    float interval = 1.0f;
+    unsigned long long rotate_bytes = 0;
+    int keep_files = 5;
+    bool processes = true;
+};
+
+// No window: sample on the background threads and stream every sample
+// until SIGINT/SIGTERM, or until the output goes away
+static int runHeadless(const HeadlessOptions& options, const string& metrics_address, int metrics_port) {
+    StreamWriter writer;
+    string error;
+    if (!writer.open(options.output, options.format, options.rotate_bytes, options.keep_files, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    
+    // Block the stop signals before any thread starts, so they all inherit
+    // the mask and only sigtimedwait() below sees them
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+    
+    g_systemSampler.addSampleHook([&writer](const SystemSample& sample) { writer.writeSystem(sample); });
+    g_systemSampler.start(options.interval);
+    if (options.processes) {
+        g_processTable.addSampleHook([&writer](const ProcessSnapshot& snapshot) { writer.writeProcesses(snapshot); });
+        g_processTable.start(options.interval);
+    }
+    if (metrics_port > 0) startExporter(metrics_address, metrics_port);
+    
+    timespec poll_interval = {1, 0};
+    while (writer.isOpen() && sigtimedwait(&stop_signals, nullptr, &poll_interval) < 0) {}
+    
+    g_exporter.stop();
+    g_processTable.stop();
+    g_systemSampler.stop();
+    writer.close();
+    return 0;
+}
+
 // Main code
-int main(int, char **)
+int main(int argc, char **argv)
 {
+    // Command line options
+    string metrics_address = "127.0.0.1";
+    int metrics_port = 0;
+    bool headless = false;
+    HeadlessOptions headless_options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--metrics-port" && has_value) {
+            metrics_port = atoi(argv[++i]);
+        } else if (arg == "--metrics-address" && has_value) {
+            metrics_address = argv[++i];
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--format" && has_value && (string(argv[i + 1]) == "ndjson" || string(argv[i + 1]) == "csv")) {
+            headless_options.format = string(argv[++i]) == "csv" ? STREAM_CSV : STREAM_NDJSON;
+        } else if (arg == "--output" && has_value) {
+            headless_options.output = argv[++i];
+        } else if (arg == "--interval" && has_value && atof(argv[i + 1]) > 0.0) {
+            headless_options.interval = atof(argv[++i]);
+        } else if (arg == "--rotate-mb" && has_value && atof(argv[i + 1]) >= 0.0 &&
+                   atof(argv[i + 1]) < (double)ULLONG_MAX / (1024 * 1024)) {
+            // Out of range doubles don't convert to an integer type
+            headless_options.rotate_bytes = (unsigned long long)(atof(argv[++i]) * 1024 * 1024);
+        } else if (arg == "--keep" && has_value) {
+            headless_options.keep_files = max(0, atoi(argv[++i]));
+        } else if (arg == "--no-processes") {
+            headless_options.processes = false;
+        } else {
+            fprintf(stderr, "usage: %s [--metrics-port PORT] [--metrics-address ADDR]\n"
+                            "       %*s [--headless [--format ndjson|csv] [--output PATH|-] [--interval SECONDS]\n"
+                            "       %*s             [--rotate-mb MB] [--keep FILES] [--no-processes]]\n",
+                    argv[0], (int)strlen(argv[0]), "", (int)strlen(argv[0]), "");
+            return 1;
+        }
+    }
+    
+    if (headless) {
+        return runHeadless(headless_options, metrics_address, metrics_port);
+    }
+    
     // Setup SDL
     // (Some versions of SDL before <2.0.10 appears to have performance/stalling issues on a minority of Windows systems,
     // depending on whether SDL_INIT_GAMECONTROLLER is enabled or disabled.. updating to latest version of SDL is recommended!)
@@ -1089,6 +2243,16 @@ int main(int, char **)
     ImGui_ImplSDL2_InitForOpenGL(window, gl_context);
     ImGui_ImplOpenGL3_Init(glsl_version);
 
+    // Start background samplers
+    g_netRegistry.start();
+    g_netlinkAvailable = g_netlinkMonitor.start();
+    g_exitedProcesses.start(g_exitedProcessesError);
+    g_processTable.addSampleHook([](const ProcessSnapshot& snapshot) { g_processAlerts.evaluate(snapshot); });
+    g_processTable.start();
+    g_systemSampler.addSampleHook([](const SystemSample& sample) { g_metricRules.evaluate(sample); });
+    g_systemSampler.start();
+    if (metrics_port > 0) startExporter(metrics_address, metrics_port);
+
     // background color
     // note : you are free to change the style of the application
     ImVec4 clear_color = ImVec4(0.0f, 0.0f, 0.0f, 0.0f);
@@ -1142,6 +2306,14 @@ int main(int, char **)
     }
 
     // Cleanup
+    g_netRegistry.stop();
+    g_netlinkMonitor.stop();
+    g_netAccounting.stop();
+    g_pressure.disableTriggers();
+    g_exitedProcesses.stop();
+    g_exporter.stop();
+    g_processTable.stop();
+    g_systemSampler.stop();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
@@ -1,49 +1,244 @@
 #include "header.h"
 
-// Get memory information from /proc/meminfo
-MemoryInfo getMemoryInfo() {
-    MemoryInfo info = {0};
+// /proc/meminfo keys and where each one lands in MemInfoSnapshot
+struct MemInfoKey {
+    const char* name;
+    size_t offset;
+};
+
+static const MemInfoKey MEMINFO_KEYS[] = {
+    {"MemTotal", offsetof(MemInfoSnapshot, mem_total)},
+    {"MemFree", offsetof(MemInfoSnapshot, mem_free)},
+    {"MemAvailable", offsetof(MemInfoSnapshot, mem_available)},
+    {"Buffers", offsetof(MemInfoSnapshot, buffers)},
+    {"Cached", offsetof(MemInfoSnapshot, cached)},
+    {"SwapCached", offsetof(MemInfoSnapshot, swap_cached)},
+    {"Active", offsetof(MemInfoSnapshot, active)},
+    {"Inactive", offsetof(MemInfoSnapshot, inactive)},
+    {"Active(anon)", offsetof(MemInfoSnapshot, active_anon)},
+    {"Inactive(anon)", offsetof(MemInfoSnapshot, inactive_anon)},
+    {"Active(file)", offsetof(MemInfoSnapshot, active_file)},
+    {"Inactive(file)", offsetof(MemInfoSnapshot, inactive_file)},
+    {"Unevictable", offsetof(MemInfoSnapshot, unevictable)},
+    {"Mlocked", offsetof(MemInfoSnapshot, mlocked)},
+    {"HighTotal", offsetof(MemInfoSnapshot, high_total)},
+    {"HighFree", offsetof(MemInfoSnapshot, high_free)},
+    {"LowTotal", offsetof(MemInfoSnapshot, low_total)},
+    {"LowFree", offsetof(MemInfoSnapshot, low_free)},
+    {"SwapTotal", offsetof(MemInfoSnapshot, swap_total)},
+    {"SwapFree", offsetof(MemInfoSnapshot, swap_free)},
+    {"Zswap", offsetof(MemInfoSnapshot, zswap)},
+    {"Zswapped", offsetof(MemInfoSnapshot, zswapped)},
+    {"Dirty", offsetof(MemInfoSnapshot, dirty)},
+    {"Writeback", offsetof(MemInfoSnapshot, writeback)},
+    {"AnonPages", offsetof(MemInfoSnapshot, anon_pages)},
+    {"Mapped", offsetof(MemInfoSnapshot, mapped)},
+    {"Shmem", offsetof(MemInfoSnapshot, shmem)},
+    {"KReclaimable", offsetof(MemInfoSnapshot, kreclaimable)},
+    {"Slab", offsetof(MemInfoSnapshot, slab)},
+    {"SReclaimable", offsetof(MemInfoSnapshot, sreclaimable)},
+    {"SUnreclaim", offsetof(MemInfoSnapshot, sunreclaim)},
+    {"KernelStack", offsetof(MemInfoSnapshot, kernel_stack)},
+    {"ShadowCallStack", offsetof(MemInfoSnapshot, shadow_call_stack)},
+    {"PageTables", offsetof(MemInfoSnapshot, page_tables)},
+    {"SecPageTables", offsetof(MemInfoSnapshot, sec_page_tables)},
+    {"NFS_Unstable", offsetof(MemInfoSnapshot, nfs_unstable)},
+    {"Bounce", offsetof(MemInfoSnapshot, bounce)},
+    {"WritebackTmp", offsetof(MemInfoSnapshot, writeback_tmp)},
+    {"CommitLimit", offsetof(MemInfoSnapshot, commit_limit)},
+    {"Committed_AS", offsetof(MemInfoSnapshot, committed_as)},
+    {"VmallocTotal", offsetof(MemInfoSnapshot, vmalloc_total)},
+    {"VmallocUsed", offsetof(MemInfoSnapshot, vmalloc_used)},
+    {"VmallocChunk", offsetof(MemInfoSnapshot, vmalloc_chunk)},
+    {"Percpu", offsetof(MemInfoSnapshot, percpu)},
+    {"HardwareCorrupted", offsetof(MemInfoSnapshot, hardware_corrupted)},
+    {"AnonHugePages", offsetof(MemInfoSnapshot, anon_huge_pages)},
+    {"ShmemHugePages", offsetof(MemInfoSnapshot, shmem_huge_pages)},
+    {"ShmemPmdMapped", offsetof(MemInfoSnapshot, shmem_pmd_mapped)},
+    {"FileHugePages", offsetof(MemInfoSnapshot, file_huge_pages)},
+    {"FilePmdMapped", offsetof(MemInfoSnapshot, file_pmd_mapped)},
+    {"CmaTotal", offsetof(MemInfoSnapshot, cma_total)},
+    {"CmaFree", offsetof(MemInfoSnapshot, cma_free)},
+    {"Unaccepted", offsetof(MemInfoSnapshot, unaccepted)},
+    {"Balloon", offsetof(MemInfoSnapshot, balloon)},
+    {"HugePages_Total", offsetof(MemInfoSnapshot, hugepages_total)},
+    {"HugePages_Free", offsetof(MemInfoSnapshot, hugepages_free)},
+    {"HugePages_Rsvd", offsetof(MemInfoSnapshot, hugepages_rsvd)},
+    {"HugePages_Surp", offsetof(MemInfoSnapshot, hugepages_surp)},
+    {"Hugepagesize", offsetof(MemInfoSnapshot, hugepagesize)},
+    {"Hugetlb", offsetof(MemInfoSnapshot, hugetlb)},
+    {"DirectMap4k", offsetof(MemInfoSnapshot, direct_map4k)},
+    {"DirectMap4M", offsetof(MemInfoSnapshot, direct_map4m)},
+    {"DirectMap2M", offsetof(MemInfoSnapshot, direct_map2m)},
+    {"DirectMap1G", offsetof(MemInfoSnapshot, direct_map1g)},
+};
+
+static const int MEMINFO_KEY_COUNT = sizeof(MEMINFO_KEYS) / sizeof(MEMINFO_KEYS[0]);
+
+// A key reduced to its first and last eight bytes plus its length. Keys of
+// up to 16 bytes are fully described by this, so comparing the words is
+// the same as comparing the strings.
+struct MemInfoKeyWords {
+    uint64_t head;
+    uint64_t tail;
+    size_t length;
     
-    ifstream meminfo("/proc/meminfo");
-    if (!meminfo.is_open()) {
-        return info;
+    MemInfoKeyWords(const char* key, size_t len) : head(0), tail(0), length(len) {
+        memcpy(&head, key, len < 8 ? len : 8);
+        if (len > 8) {
+            memcpy(&tail, key + len - 8, 8);
+        }
     }
     
-    string line;
-    unsigned long mem_total = 0, mem_free = 0, mem_available = 0;
-    unsigned long buffers = 0, cached = 0, swap_total = 0, swap_free = 0;
-    
-    while (getline(meminfo, line)) {
-        if (line.find("MemTotal:") == 0) {
-            sscanf(line.c_str(), "MemTotal: %lu kB", &mem_total);
-        } else if (line.find("MemFree:") == 0) {
-            sscanf(line.c_str(), "MemFree: %lu kB", &mem_free);
-        } else if (line.find("MemAvailable:") == 0) {
-            sscanf(line.c_str(), "MemAvailable: %lu kB", &mem_available);
-        } else if (line.find("Buffers:") == 0) {
-            sscanf(line.c_str(), "Buffers: %lu kB", &buffers);
-        } else if (line.find("Cached:") == 0) {
-            sscanf(line.c_str(), "Cached: %lu kB", &cached);
-        } else if (line.find("SwapTotal:") == 0) {
-            sscanf(line.c_str(), "SwapTotal: %lu kB", &swap_total);
-        } else if (line.find("SwapFree:") == 0) {
-            sscanf(line.c_str(), "SwapFree: %lu kB", &swap_free);
+    // Perfect hash over MEMINFO_KEYS: the words are folded together with the
+    // length and multiplied down to a slot of a 256 entry table. The
+    // multiplier was searched for so every key lands in its own slot (on
+    // little-endian loads). Re-check it if keys are added.
+    unsigned char slot() const {
+        uint64_t x = (head ^ ((tail << 29) | (tail >> 35))) + length;
+        return (unsigned char)((x * 0xfaf75b08e6960f2dull) >> 56);
+    }
+};
+
+struct MemInfoKeyTable {
+    unsigned char slots[256];   // Index into MEMINFO_KEYS, 0xFF when empty
+    uint64_t heads[MEMINFO_KEY_COUNT];
+    uint64_t tails[MEMINFO_KEY_COUNT];
+    unsigned char lengths[MEMINFO_KEY_COUNT];
+    
+    MemInfoKeyTable() {
+        memset(slots, 0xFF, sizeof(slots));
+        for (int i = 0; i < MEMINFO_KEY_COUNT; i++) {
+            MemInfoKeyWords words(MEMINFO_KEYS[i].name, strlen(MEMINFO_KEYS[i].name));
+            heads[i] = words.head;
+            tails[i] = words.tail;
+            lengths[i] = (unsigned char)words.length;
+            slots[words.slot()] = (unsigned char)i;
+        }
+    }
+    
+    // Index of the key in MEMINFO_KEYS, or -1 if it is not one of them
+    int find(const char* key, size_t len) const {
+        MemInfoKeyWords words(key, len);
+        unsigned char index = slots[words.slot()];
+        if (index == 0xFF || lengths[index] != len ||
+            heads[index] != words.head || tails[index] != words.tail) {
+            return -1;
+        }
+        // Longer keys have middle bytes the words do not cover
+        if (len > 16 && memcmp(MEMINFO_KEYS[index].name, key, len) != 0) {
+            return -1;
+        }
+        return index;
+    }
+};
+
+static const MemInfoKeyTable g_meminfoKeys;
+
+// Scan helpers for parseMemInfoText, eight bytes at a time. A byte equal to
+// one of the targets becomes zero after the xor, and the classic "has zero
+// byte" trick flags it; the lowest flagged byte is always a real match.
+static const uint64_t SWAR_ONES = 0x0101010101010101ull;
+static const uint64_t SWAR_HIGHS = 0x8080808080808080ull;
+
+static inline uint64_t swarZeroBytes(uint64_t v) {
+    return (v - SWAR_ONES) & ~v & SWAR_HIGHS;
+}
+
+// First ':' or '\n' at or after p, or end
+static inline const char* findKeyEnd(const char* p, const char* end) {
+    while (p + 8 <= end) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        uint64_t hits = swarZeroBytes(v ^ (SWAR_ONES * ':')) | swarZeroBytes(v ^ (SWAR_ONES * '\n'));
+        if (hits) return p + (__builtin_ctzll(hits) >> 3);
+        p += 8;
+    }
+    while (p < end && *p != ':' && *p != '\n') p++;
+    return p;
+}
+
+// First byte that is not a space at or after p, or end
+static inline const char* skipSpaces(const char* p, const char* end) {
+    while (p + 8 <= end) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        uint64_t other = v ^ (SWAR_ONES * ' ');
+        if (other) return p + (__builtin_ctzll(other) >> 3);
+        p += 8;
+    }
+    while (p < end && *p == ' ') p++;
+    return p;
+}
+
+// Parse the text of /proc/meminfo into a snapshot. Values are written
+// straight into the struct, nothing is allocated.
+void parseMemInfoText(const char* text, size_t len, MemInfoSnapshot& snapshot) {
+    memset(&snapshot, 0, sizeof(snapshot));
+    const char* p = text;
+    const char* end = text + len;
+    while (p < end) {
+        // Key runs up to the colon
+        const char* key = p;
+        p = findKeyEnd(p, end);
+        if (p >= end) break;
+        if (*p == '\n') { p++; continue; }
+        size_t key_len = p - key;
+        p = skipSpaces(p + 1, end);
+        
+        unsigned long long value = 0;
+        while (p < end && (unsigned)(*p - '0') <= 9) {
+            value = value * 10 + (*p - '0');
+            p++;
         }
+        // Rest of the line is at most " kB"
+        while (p < end && *p != '\n') p++;
+        p++;
+        
+        int index = g_meminfoKeys.find(key, key_len);
+        if (index < 0) continue;   // Key this build does not know about
+        *(unsigned long long*)((char*)&snapshot + MEMINFO_KEYS[index].offset) = value;
+    }
+}
+
+// Read /proc/meminfo in a single call. The file stays open and is re-read
+// with pread into a stack buffer, so a sample costs one syscall.
+bool parseMemInfo(MemInfoSnapshot& snapshot) {
+    static int fd = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+    char buffer[8192];
+    ssize_t len = fd >= 0 ? pread(fd, buffer, sizeof(buffer), 0) : -1;
+    if (len <= 0) {
+        memset(&snapshot, 0, sizeof(snapshot));
+        return false;
     }
+    parseMemInfoText(buffer, len, snapshot);
+    return true;
+}
+
+// Derive the summary figures from an already parsed snapshot
+MemoryInfo getMemoryInfo(const MemInfoSnapshot& snapshot) {
+    MemoryInfo info = {0};
     
     // Convert kB to bytes
-    info.total_ram = mem_total * 1024;
-    info.free_ram = mem_free * 1024;  // Use actual free (not available)
+    info.total_ram = snapshot.mem_total * 1024;
+    info.free_ram = snapshot.mem_free * 1024;  // Use actual free (not available)
     // Calculate used memory like modern 'free' command: total - available
-    info.used_ram = (mem_total - mem_available) * 1024;
+    info.used_ram = (snapshot.mem_total - snapshot.mem_available) * 1024;
     
-    info.total_swap = swap_total * 1024;
-    info.free_swap = swap_free * 1024;
-    info.used_swap = (swap_total - swap_free) * 1024;
+    info.total_swap = snapshot.swap_total * 1024;
+    info.free_swap = snapshot.swap_free * 1024;
+    info.used_swap = (snapshot.swap_total - snapshot.swap_free) * 1024;
     
     return info;
 }
 
+// Get memory information from /proc/meminfo
+MemoryInfo getMemoryInfo() {
+    MemInfoSnapshot snapshot;
+    parseMemInfo(snapshot);
+    return getMemoryInfo(snapshot);
+}
+
 // Get disk usage information
 DiskInfo getDiskInfo(const string& path) {
     DiskInfo info = {0};
@@ -61,6 +256,16 @@ DiskInfo getDiskInfo(const string& path) {
     return info;
 }
 
+// Whether a mount is a real block-device filesystem worth showing
+static bool isRealDiskMount(const string& device, const string& mount_point, const string& fs_type) {
+    return device.find("/dev/") == 0 && 
+           fs_type != "tmpfs" && fs_type != "devtmpfs" && 
+           fs_type != "sysfs" && fs_type != "proc" &&
+           fs_type != "squashfs" && // Skip snap packages
+           device.find("/dev/loop") != 0 && // Skip loop devices
+           mount_point.find("/snap/") != 0; // Skip snap mount points
+}
+
 // Get information for all mounted disks
 vector<DiskInfo> getAllDisks() {
     vector<DiskInfo> disks;
@@ -83,18 +288,14 @@ vector<DiskInfo> getAllDisks() {
         ss >> device >> mount_point >> fs_type;
         
         // Skip virtual filesystems, snap mounts, and duplicates
-        if (device.find("/dev/") == 0 && 
-            fs_type != "tmpfs" && fs_type != "devtmpfs" && 
-            fs_type != "sysfs" && fs_type != "proc" &&
-            fs_type != "squashfs" && // Skip snap packages
-            device.find("/dev/loop") != 0 && // Skip loop devices
-            mount_point.find("/snap/") != 0 && // Skip snap mount points
+        if (isRealDiskMount(device, mount_point, fs_type) &&
             seen_devices.find(device) == seen_devices.end()) {
             
             DiskInfo info = getDiskInfo(mount_point);
             if (info.total_space > 0) {
                 info.original_path = mount_point;  // Store original path
                 info.mount_point = mount_point + " (" + device + ")"; // Show device name
+                info.device = getBlockDeviceName(device);
                 disks.push_back(info);
                 seen_devices.insert(device);
             }
@@ -114,6 +315,431 @@ vector<DiskInfo> getAllDisks() {
     return disks;
 }
 
+// Read an open file from its current position to EOF into a reusable buffer
+static bool readAllFrom(int fd, vector<char>& buffer) {
+    if (buffer.size() < 4096) buffer.resize(4096);
+    size_t used = 0;
+    while (true) {
+        if (used + 1 >= buffer.size()) buffer.resize(buffer.size() * 2);
+        ssize_t len = read(fd, buffer.data() + used, buffer.size() - used - 1);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (len == 0) break;
+        used += len;
+    }
+    
+    buffer[used] = '\0';
+    return true;
+}
+
+// Read a whole (proc) file into a reusable buffer, NUL-terminated.
+// The buffer keeps its capacity, so repeated reads do not allocate.
+bool readFileInto(const char* path, vector<char>& buffer) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    
+    bool ok = readAllFrom(fd, buffer);
+    close(fd);
+    return ok;
+}
+
+// Resolve a device path (e.g. /dev/mapper/root or /dev/sda1) to its /proc/diskstats name
+string getBlockDeviceName(const string& device_path) {
+    char resolved[PATH_MAX];
+    string path = device_path;
+    if (realpath(device_path.c_str(), resolved) != nullptr) {
+        path = resolved; // /dev/mapper/* links resolve to /dev/dm-N
+    }
+    
+    size_t slash_pos = path.find_last_of('/');
+    return slash_pos == string::npos ? path : path.substr(slash_pos + 1);
+}
+
+DiskStatsCollector::DiskStatsCollector() : primed(false), samples(0) {}
+
+int DiskStatsCollector::findDevice(const string& name) const {
+    return findDevice(name.data(), name.size());
+}
+
+int DiskStatsCollector::findDevice(const char* name, size_t len) const {
+    for (int i = 0; i < (int)names.size(); i++) {
+        if (names[i].size() == len && memcmp(names[i].data(), name, len) == 0) return i;
+    }
+    return -1;
+}
+
+int DiskStatsCollector::addDevice(const char* name, size_t len) {
+    names.emplace_back(name, len);
+    for (auto* column : {&reads, &writes, &sectors_read, &sectors_written, &read_ms, &write_ms, &io_ms, &weighted_ms, &in_flight}) {
+        column->push_back(0);
+    }
+    for (auto* column : {&read_iops, &write_iops, &read_bytes_per_sec, &write_bytes_per_sec,
+                         &utilization, &read_await_ms, &write_await_ms, &queue_depth}) {
+        column->push_back(0.0f);
+    }
+    read_history.emplace_back();
+    write_history.emplace_back();
+    util_history.emplace_back();
+    device_seen.push_back(samples);
+    device_primed.push_back(false);
+    return (int)names.size() - 1;
+}
+
+void DiskStatsCollector::removeDevice(int index) {
+    names.erase(names.begin() + index);
+    for (auto* column : {&reads, &writes, &sectors_read, &sectors_written, &read_ms, &write_ms, &io_ms, &weighted_ms, &in_flight}) {
+        column->erase(column->begin() + index);
+    }
+    for (auto* column : {&read_iops, &write_iops, &read_bytes_per_sec, &write_bytes_per_sec,
+                         &utilization, &read_await_ms, &write_await_ms, &queue_depth}) {
+        column->erase(column->begin() + index);
+    }
+    read_history.erase(read_history.begin() + index);
+    write_history.erase(write_history.begin() + index);
+    util_history.erase(util_history.begin() + index);
+    device_seen.erase(device_seen.begin() + index);
+    device_primed.erase(device_primed.begin() + index);
+}
+
+// Read /proc/diskstats once and update rates and history of every device
+void DiskStatsCollector::sample() {
+    if (!readFileInto("/proc/diskstats", read_buffer)) return;
+    
+    auto now = chrono::steady_clock::now();
+    float delta_time = chrono::duration<float>(now - last_time).count();
+    float delta_ms = delta_time * 1000.0f;
+    bool have_delta = primed && delta_time > 0;
+    
+    char* cursor = read_buffer.data();
+    while (*cursor) {
+        char* line_end = strchr(cursor, '\n');
+        if (line_end) *line_end = '\0';
+        
+        // major minor name, then the counters
+        char* field = cursor;
+        strtoul(field, &field, 10);
+        strtoul(field, &field, 10);
+        while (*field == ' ') field++;
+        char* name = field;
+        while (*field && *field != ' ') field++;
+        size_t name_len = field - name;
+        
+        unsigned long long values[11] = {0};
+        for (int i = 0; i < 11 && *field; i++) {
+            values[i] = strtoull(field, &field, 10);
+        }
+        
+        cursor = line_end ? line_end + 1 : field + strlen(field);
+        
+        // Skip loop and ram devices, like getAllDisks()
+        if (name_len == 0 || strncmp(name, "loop", 4) == 0 || strncmp(name, "ram", 3) == 0) continue;
+        
+        int index = findDevice(name, name_len);
+        if (index < 0) index = addDevice(name, name_len);
+        device_seen[index] = samples + 1;
+        
+        unsigned long long cur_reads = values[0], cur_sectors_read = values[2], cur_read_ms = values[3];
+        unsigned long long cur_writes = values[4], cur_sectors_written = values[6], cur_write_ms = values[7];
+        unsigned long long cur_in_flight = values[8], cur_io_ms = values[9], cur_weighted_ms = values[10];
+        
+        // A device's first sample (hot-plugged, or the first pass) only
+        // primes its counters; diffing against zeros would be its lifetime
+        if (have_delta && device_primed[index] && cur_reads >= reads[index] && cur_writes >= writes[index]) {
+            unsigned long long delta_reads = cur_reads - reads[index];
+            unsigned long long delta_writes = cur_writes - writes[index];
+            
+            read_iops[index] = delta_reads / delta_time;
+            write_iops[index] = delta_writes / delta_time;
+            read_bytes_per_sec[index] = (cur_sectors_read - sectors_read[index]) * 512.0f / delta_time;
+            write_bytes_per_sec[index] = (cur_sectors_written - sectors_written[index]) * 512.0f / delta_time;
+            utilization[index] = min(100.0f, (cur_io_ms - io_ms[index]) * 100.0f / delta_ms);
+            read_await_ms[index] = delta_reads > 0 ? (float)(cur_read_ms - read_ms[index]) / delta_reads : 0.0f;
+            write_await_ms[index] = delta_writes > 0 ? (float)(cur_write_ms - write_ms[index]) / delta_writes : 0.0f;
+            queue_depth[index] = (cur_weighted_ms - weighted_ms[index]) / delta_ms;
+            
+            read_history[index].addValue(read_bytes_per_sec[index] / 1024.0f);
+            write_history[index].addValue(write_bytes_per_sec[index] / 1024.0f);
+            util_history[index].addValue(utilization[index]);
+        }
+        
+        reads[index] = cur_reads;
+        writes[index] = cur_writes;
+        sectors_read[index] = cur_sectors_read;
+        sectors_written[index] = cur_sectors_written;
+        read_ms[index] = cur_read_ms;
+        write_ms[index] = cur_write_ms;
+        io_ms[index] = cur_io_ms;
+        weighted_ms[index] = cur_weighted_ms;
+        in_flight[index] = cur_in_flight;
+        device_primed[index] = true;
+    }
+    
+    // Drop devices that were unplugged
+    samples++;
+    for (int i = (int)names.size() - 1; i >= 0; i--) {
+        if (device_seen[i] != samples) removeDevice(i);
+    }
+    
+    primed = true;
+    last_time = now;
+}
+
+// Undo the octal escapes (\040 for space etc.) used in mountinfo paths
+static string unescapeMountField(const char* start, size_t len) {
+    string result;
+    result.reserve(len);
+    for (size_t i = 0; i < len; i++) {
+        if (start[i] == '\\' && i + 3 < len && isdigit(start[i + 1]) && isdigit(start[i + 2]) && isdigit(start[i + 3])) {
+            result += (char)((start[i + 1] - '0') * 64 + (start[i + 2] - '0') * 8 + (start[i + 3] - '0'));
+            i += 3;
+        } else {
+            result += start[i];
+        }
+    }
+    return result;
+}
+
+StatvfsProbePool::StatvfsProbePool() : state(make_shared<State>()) {
+    state->workers = 0;
+    state->idle_workers = 0;
+    state->shutdown = false;
+}
+
+StatvfsProbePool::~StatvfsProbePool() {
+    {
+        lock_guard<mutex> guard(state->lock);
+        state->shutdown = true;
+    }
+    state->wake.notify_all();
+    // Workers are detached: idle ones exit now, hung ones exit when statvfs returns
+}
+
+// Queue a statvfs probe for a mount point
+void StatvfsProbePool::submit(const string& path) {
+    lock_guard<mutex> guard(state->lock);
+    state->jobs.push_back(path);
+    
+    // Every worker may be stuck in a hung filesystem; add one if nobody is free
+    if (state->idle_workers == 0 && state->workers < MAX_WORKERS) {
+        state->workers++;
+        thread(workerLoop, state).detach();
+    } else {
+        state->wake.notify_one();
+    }
+}
+
+void StatvfsProbePool::collect(vector<DiskInfo>& results) {
+    results.clear();
+    lock_guard<mutex> guard(state->lock);
+    results.swap(state->results);
+}
+
+void StatvfsProbePool::workerLoop(shared_ptr<State> state) {
+    unique_lock<mutex> guard(state->lock);
+    while (true) {
+        state->idle_workers++;
+        state->wake.wait(guard, [&state] { return state->shutdown || !state->jobs.empty(); });
+        state->idle_workers--;
+        if (state->shutdown) break;
+        
+        string path = state->jobs.front();
+        state->jobs.pop_front();
+        
+        // This is the call that may never return on a dead NFS server
+        guard.unlock();
+        DiskInfo info = getDiskInfo(path);
+        info.original_path = path;
+        guard.lock();
+        
+        state->results.push_back(info);
+    }
+    state->workers--;
+}
+
+MountRegistry::MountRegistry()
+    : mountinfo_fd(-1), mounts_dirty(true), capacity_interval(5.0f), check_interval(1.0f), probe_deadline(2.0f) {
+    // POLLPRI on /proc/self/mountinfo fires whenever the mount table changes
+    mountinfo_fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+}
+
+MountRegistry::~MountRegistry() {
+    if (mountinfo_fd != -1) {
+        close(mountinfo_fd);
+    }
+}
+
+void MountRegistry::setCapacityInterval(float seconds) {
+    capacity_interval = max(seconds, 0.5f);
+}
+
+// Parse /proc/self/mountinfo into the mount list, keeping capacities of known mounts
+void MountRegistry::parseMounts() {
+    bool ok;
+    if (mountinfo_fd != -1) {
+        // Reading the file from the start also re-arms the change notification
+        ok = lseek(mountinfo_fd, 0, SEEK_SET) == 0 && readAllFrom(mountinfo_fd, read_buffer);
+    } else {
+        ok = readFileInto("/proc/self/mountinfo", read_buffer);
+    }
+    if (!ok) return;
+    
+    vector<DiskInfo> parsed;
+    set<string> seen_devices; // To avoid duplicates
+    
+    char* cursor = read_buffer.data();
+    while (*cursor) {
+        char* line_end = strchr(cursor, '\n');
+        if (line_end) *line_end = '\0';
+        char* line = cursor;
+        cursor = line_end ? line_end + 1 : line + strlen(line);
+        
+        // id parent major:minor root mount_point options [optional...] - fs_type source super_options
+        const char* fields[5];
+        size_t lengths[5];
+        char* field = line;
+        int count = 0;
+        for (; count < 5 && *field; count++) {
+            while (*field == ' ') field++;
+            fields[count] = field;
+            while (*field && *field != ' ') field++;
+            lengths[count] = field - fields[count];
+        }
+        if (count < 5) continue;
+        
+        char* separator = strstr(field, " - ");
+        if (!separator) continue;
+        char* fs_start = separator + 3;
+        char* fs_end = strchr(fs_start, ' ');
+        if (!fs_end) continue;
+        char* source_start = fs_end + 1;
+        char* source_end = strchr(source_start, ' ');
+        if (!source_end) source_end = source_start + strlen(source_start);
+        
+        string mount_point = unescapeMountField(fields[4], lengths[4]);
+        string fs_type(fs_start, fs_end - fs_start);
+        string device = unescapeMountField(source_start, source_end - source_start);
+        
+        if (!isRealDiskMount(device, mount_point, fs_type) || seen_devices.count(device)) continue;
+        seen_devices.insert(device);
+        
+        DiskInfo info = {0};
+        info.original_path = mount_point;
+        info.mount_point = mount_point + " (" + device + ")";
+        info.device = getBlockDeviceName(device);
+        
+        // Keep the last known capacity so the UI doesn't flicker until the next refresh
+        for (const auto& known : mounts) {
+            if (known.original_path == mount_point) {
+                info.total_space = known.total_space;
+                info.free_space = known.free_space;
+                info.used_space = known.used_space;
+                info.unresponsive = known.unresponsive;
+                break;
+            }
+        }
+        parsed.push_back(info);
+    }
+    
+    // If no real disks found, show the root filesystem
+    if (parsed.empty()) {
+        DiskInfo root_info = {0};
+        root_info.original_path = "/";
+        root_info.mount_point = "/";
+        parsed.push_back(root_info);
+    }
+    
+    mounts.swap(parsed);
+    
+    // Forget probe state of unmounted paths (hung probes are kept until they return)
+    for (auto it = probes.begin(); it != probes.end();) {
+        bool mounted = false;
+        for (const auto& disk : mounts) {
+            if (disk.original_path == it->first) { mounted = true; break; }
+        }
+        if (!mounted && !it->second.in_flight) it = probes.erase(it);
+        else ++it;
+    }
+}
+
+// Start statvfs probes for every mount that has none in flight
+void MountRegistry::refreshCapacity() {
+    auto now = chrono::steady_clock::now();
+    for (const auto& disk : mounts) {
+        ProbeState& probe = probes[disk.original_path];
+        if (probe.in_flight) continue; // Still waiting (or hung), don't pile up probes
+        probe.in_flight = true;
+        probe.submitted = now;
+        probe_pool.submit(disk.original_path);
+    }
+}
+
+// Apply finished probes and flag mounts whose probe is past its deadline
+void MountRegistry::collectProbes() {
+    probe_pool.collect(probe_results);
+    for (const auto& result : probe_results) {
+        probes[result.original_path].in_flight = false;
+        for (auto& disk : mounts) {
+            if (disk.original_path == result.original_path) {
+                disk.total_space = result.total_space;
+                disk.free_space = result.free_space;
+                disk.used_space = result.used_space;
+                disk.unresponsive = false; // Recovered
+                break;
+            }
+        }
+    }
+    
+    auto now = chrono::steady_clock::now();
+    for (auto& disk : mounts) {
+        auto probe = probes.find(disk.original_path);
+        if (probe != probes.end() && probe->second.in_flight &&
+            chrono::duration<float>(now - probe->second.submitted).count() > probe_deadline) {
+            disk.unresponsive = true;
+        }
+    }
+}
+
+// Re-parse mounts only after a change notification, refresh capacity on its own cadence
+void MountRegistry::update() {
+    auto now = chrono::steady_clock::now();
+    
+    if (!mounts_dirty && chrono::duration<float>(now - last_check).count() >= check_interval) {
+        last_check = now;
+        if (mountinfo_fd == -1) {
+            mounts_dirty = true; // No notifications available, fall back to re-reading
+        } else {
+            struct pollfd pfd = {mountinfo_fd, POLLPRI, 0};
+            if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR))) {
+                mounts_dirty = true;
+            }
+        }
+    }
+    
+    bool capacity_due = chrono::duration<float>(now - last_capacity).count() >= capacity_interval;
+    if (mounts_dirty) {
+        parseMounts();
+        mounts_dirty = false;
+        last_check = now;
+        capacity_due = true;
+    }
+    
+    if (capacity_due) {
+        refreshCapacity();
+        last_capacity = now;
+    }
+    
+    collectProbes();
+}
+
+// Percentage of the usable space that is used (matches df)
+float getDiskUsagePercentage(const DiskInfo& info) {
+    unsigned long usable_space = info.used_space + info.free_space;
+    if (usable_space == 0) return 0.0f;
+    return (float)info.used_space * 100.0f / usable_space;
+}
+
 // Format size in bytes to human-readable format (KB, MB, GB)
 string formatSize(unsigned long size_in_bytes) {
     float size = size_in_bytes;
@@ -132,14 +758,20 @@ string formatSize(unsigned long size_in_bytes) {
 
 // Get RAM usage percentage
 float getMemoryUsagePercentage() {
-    MemoryInfo info = getMemoryInfo();
+    return getMemoryUsagePercentage(getMemoryInfo());
+}
+
+float getMemoryUsagePercentage(const MemoryInfo& info) {
     if (info.total_ram == 0) return 0.0f;
     return (float)info.used_ram * 100.0f / info.total_ram;
 }
 
 // Get SWAP usage percentage
 float getSwapUsagePercentage() {
-    MemoryInfo info = getMemoryInfo();
+    return getSwapUsagePercentage(getMemoryInfo());
+}
+
+float getSwapUsagePercentage(const MemoryInfo& info) {
     if (info.total_swap == 0) return 0.0f;
     return (float)info.used_swap * 100.0f / info.total_swap;
 }
@@ -166,7 +798,7 @@ string getProcessName(int pid) {
 }
 
 // Get detailed information about a process
-Process getProcessInfo(int pid) {
+Process getProcessInfo(int pid, unsigned long total_ram) {
     Process proc;
     proc.pid = pid;
     
@@ -225,6 +857,7 @@ Process getProcessInfo(int pid) {
     proc.utime = utime;
     proc.stime = stime;
     proc.vsize = vsize;
+    proc.start_time = starttime;
     
     // Get RSS (Resident Set Size)
     string status_path = "/proc/" + to_string(pid) + "/status";
@@ -232,7 +865,9 @@ Process getProcessInfo(int pid) {
     if (status_file.is_open()) {
         string status_line;
         while (getline(status_file, status_line)) {
-            if (status_line.find("VmRSS:") == 0) {
+            if (status_line.compare(0, 4, "Uid:") == 0) {
+                proc.uid = (uid_t)strtoul(status_line.c_str() + 4, nullptr, 10);
+            } else if (status_line.find("VmRSS:") == 0) {
                 // Extract the RSS value in kB
                 size_t colon_pos = status_line.find(':');
                 if (colon_pos != string::npos) {
@@ -247,10 +882,13 @@ Process getProcessInfo(int pid) {
         }
     }
     
-    // Calculate memory usage percentage
-    MemoryInfo mem_info = getMemoryInfo();
-    if (mem_info.total_ram > 0) {
-        proc.memory_usage = (float)proc.rss * 100.0f / mem_info.total_ram;
+    // Calculate memory usage percentage, callers walking many processes pass
+    // the total in so meminfo is not re-read for each one
+    if (total_ram == 0) {
+        total_ram = getMemoryInfo().total_ram;
+    }
+    if (total_ram > 0) {
+        proc.memory_usage = (float)proc.rss * 100.0f / total_ram;
     } else {
         proc.memory_usage = 0.0f;
     }
@@ -265,12 +903,14 @@ vector<Process> getAllProcesses() {
     DIR* proc_dir = opendir("/proc");
     if (!proc_dir) return processes;
     
+    unsigned long total_ram = getMemoryInfo().total_ram;
+    
     struct dirent* entry;
     while ((entry = readdir(proc_dir)) != nullptr) {
         // Check if the directory name is a number (PID)
         if (isdigit(entry->d_name[0])) {
             int pid = atoi(entry->d_name);
-            Process proc = getProcessInfo(pid);
+            Process proc = getProcessInfo(pid, total_ram);
             if (!proc.name.empty()) { // Only add valid processes
                 processes.push_back(proc);
             }
@@ -284,15 +924,14 @@ vector<Process> getAllProcesses() {
 // Update CPU usage for all processes
 void updateProcessCpuUsage(vector<Process>& processes) {
     static map<int, pair<long long, long long>> prev_cpu_times; // pid -> (utime, stime)
-    static long prev_total_time = 0;
-    
-    // Get current system uptime
-    long uptime = getSystemUptime();
-    if (uptime == 0) return;
+    static double prev_total_time = 0;
     
-    // Calculate total CPU time
-    long total_time = uptime * sysconf(_SC_CLK_TCK);
-    long total_time_diff = total_time - prev_total_time;
+    // Elapsed time in clock ticks; whole-second uptime would give a zero
+    // divisor for sub-second sampling intervals
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double total_time = (now.tv_sec + now.tv_nsec / 1e9) * sysconf(_SC_CLK_TCK);
+    double total_time_diff = total_time - prev_total_time;
     if (total_time_diff <= 0) return;
     
     // Update CPU usage for each process
@@ -318,52 +957,1559 @@ void updateProcessCpuUsage(vector<Process>& processes) {
     prev_total_time = total_time;
 }
 
-// Kill a process by PID
-bool killProcess(int pid) {
-    if (pid <= 0) return false;
-    return (kill(pid, SIGTERM) == 0);
+ThreadSampler::ThreadSampler() : target_pid(-1), task_fd(-1) {}
+
+ThreadSampler::~ThreadSampler() {
+    if (task_fd >= 0) close(task_fd);
+}
+
+// Switch to another process; its thread history starts from scratch
+bool ThreadSampler::setPid(int pid) {
+    if (pid == target_pid && task_fd >= 0) return true;
+    if (task_fd >= 0) close(task_fd);
+    target_pid = pid;
+    current.clear();
+    previous.clear();
+    
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    task_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (task_fd >= 0) {
+        // Sized once for a large process, later samples reuse the capacity
+        current.reserve(1024);
+        previous.reserve(1024);
+    }
+    last_time = chrono::steady_clock::now();
+    return task_fd >= 0;
+}
+
+// Parse /proc/[pid]/task/[tid]/stat into info
+bool ThreadSampler::readThread(int tid, ThreadInfo& info) {
+    char path[32];
+    snprintf(path, sizeof(path), "%d/stat", tid);
+    int fd = openat(task_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    ssize_t len = read(fd, stat_buffer, sizeof(stat_buffer) - 1);
+    close(fd);
+    if (len <= 0) return false;
+    stat_buffer[len] = '\0';
+    
+    // comm may contain spaces and parentheses, it ends at the last ')'
+    char* open_paren = strchr(stat_buffer, '(');
+    char* close_paren = strrchr(stat_buffer, ')');
+    if (!open_paren || !close_paren || close_paren < open_paren) return false;
+    size_t name_len = min((size_t)(close_paren - open_paren - 1), sizeof(info.name) - 1);
+    memcpy(info.name, open_paren + 1, name_len);
+    info.name[name_len] = '\0';
+    info.tid = tid;
+    
+    // Fields after the name, numbered as in proc(5): state is field 3
+    char* p = close_paren + 2;
+    int field = 3;
+    while (*p && field <= 39) {
+        char* end;
+        switch (field) {
+            case 3: info.state = *p; break;
+            case 14: info.utime = strtoull(p, &end, 10); break;
+            case 15: info.stime = strtoull(p, &end, 10); break;
+            case 18: info.priority = (int)strtol(p, &end, 10); break;
+            case 19: info.nice = (int)strtol(p, &end, 10); break;
+            case 39: info.processor = (int)strtol(p, &end, 10); break;
+        }
+        p = strchr(p, ' ');
+        if (!p) break;
+        p++;
+        field++;
+    }
+    return field > 39;
+}
+
+bool ThreadSampler::sample() {
+    if (task_fd < 0) return false;
+    
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    double elapsed_ticks = chrono::duration<double>(now - last_time).count() * sysconf(_SC_CLK_TCK);
+    last_time = now;
+    
+    current.swap(previous);
+    current.clear();
+    
+    // Re-list the held task directory from the start
+    lseek(task_fd, 0, SEEK_SET);
+    bool listed = false;
+    for (;;) {
+        long nread = syscall(SYS_getdents64, task_fd, dirent_buffer, sizeof(dirent_buffer));
+        if (nread <= 0) break;
+        listed = true;
+        for (long offset = 0; offset < nread; ) {
+            struct dirent64* entry = (struct dirent64*)(dirent_buffer + offset);
+            offset += entry->d_reclen;
+            if (!isdigit(entry->d_name[0])) continue;
+            
+            ThreadInfo info;
+            if (!readThread(atoi(entry->d_name), info)) continue;   // Thread exited
+            info.cpu_usage = 0.0f;
+            current.push_back(info);
+        }
+    }
+    if (!listed) return false;   // Process exited
+    
+    // Per-thread CPU from the tick deltas against the previous sample
+    sort(current.begin(), current.end(), [](const ThreadInfo& a, const ThreadInfo& b) { return a.tid < b.tid; });
+    auto prev = previous.begin();
+    for (auto& info : current) {
+        while (prev != previous.end() && prev->tid < info.tid) ++prev;
+        if (prev != previous.end() && prev->tid == info.tid && elapsed_ticks > 0) {
+            unsigned long long ticks = (info.utime + info.stime) - (prev->utime + prev->stime);
+            info.cpu_usage = (float)(ticks * 100.0 / elapsed_ticks);
+        }
+    }
+    return true;
+}
+
+// Generic netlink attributes: header, payload, padding to 4 bytes
+#define GENL_ATTR_DATA(attr) ((char*)(attr) + NLA_HDRLEN)
+#define GENL_ATTR_PAYLOAD(attr) ((int)(attr)->nla_len - NLA_HDRLEN)
+
+ExitedProcessMonitor::ExitedProcessMonitor()
+    : netlink_fd(-1), wake_fd(-1), family_id(0), sequence(0), ring(RING_CAPACITY),
+      ring_next(0), ring_count(0), running(false), total_exited(0), lost_events(0) {}
+
+ExitedProcessMonitor::~ExitedProcessMonitor() {
+    stop();
+}
+
+// Send a TASKSTATS_CMD_GET carrying one string attribute
+bool ExitedProcessMonitor::sendCommand(int attr_type, const string& value) {
+    struct {
+        struct nlmsghdr header;
+        struct genlmsghdr genl;
+        char attrs[256];
+    } request;
+    memset(&request, 0, sizeof(request));
+    
+    struct nlattr* attr = (struct nlattr*)request.attrs;
+    attr->nla_type = attr_type;
+    attr->nla_len = NLA_HDRLEN + value.size() + 1;
+    memcpy(GENL_ATTR_DATA(attr), value.c_str(), value.size() + 1);
+    
+    request.header.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN) + NLA_ALIGN(attr->nla_len);
+    request.header.nlmsg_type = family_id;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.header.nlmsg_seq = ++sequence;
+    request.header.nlmsg_pid = getpid();
+    request.genl.cmd = TASKSTATS_CMD_GET;
+    request.genl.version = TASKSTATS_GENL_VERSION;
+    
+    return send(netlink_fd, &request, request.header.nlmsg_len, 0) != -1;
+}
+
+// Look up the numeric id of the TASKSTATS generic netlink family
+bool ExitedProcessMonitor::resolveFamily() {
+    struct {
+        struct nlmsghdr header;
+        struct genlmsghdr genl;
+        char attrs[64];
+    } request;
+    memset(&request, 0, sizeof(request));
+    
+    struct nlattr* attr = (struct nlattr*)request.attrs;
+    attr->nla_type = CTRL_ATTR_FAMILY_NAME;
+    attr->nla_len = NLA_HDRLEN + sizeof(TASKSTATS_GENL_NAME);
+    memcpy(GENL_ATTR_DATA(attr), TASKSTATS_GENL_NAME, sizeof(TASKSTATS_GENL_NAME));
+    
+    request.header.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN) + NLA_ALIGN(attr->nla_len);
+    request.header.nlmsg_type = GENL_ID_CTRL;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.header.nlmsg_seq = ++sequence;
+    request.header.nlmsg_pid = getpid();
+    request.genl.cmd = CTRL_CMD_GETFAMILY;
+    request.genl.version = 1;
+    if (send(netlink_fd, &request, request.header.nlmsg_len, 0) == -1) {
+        return false;
+    }
+    
+    alignas(struct nlmsghdr) char buffer[4096];
+    ssize_t len = recv(netlink_fd, buffer, sizeof(buffer), 0);
+    if (len <= 0) return false;
+    
+    struct nlmsghdr* msg = (struct nlmsghdr*)buffer;
+    if (!NLMSG_OK(msg, (unsigned int)len) || msg->nlmsg_type == NLMSG_ERROR) {
+        return false;
+    }
+    char* attrs = (char*)NLMSG_DATA(msg) + GENL_HDRLEN;
+    int remaining = msg->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    while (remaining >= NLA_HDRLEN) {
+        struct nlattr* current = (struct nlattr*)attrs;
+        if (current->nla_len < NLA_HDRLEN || current->nla_len > remaining) break;
+        if (current->nla_type == CTRL_ATTR_FAMILY_ID) {
+            family_id = *(unsigned short*)GENL_ATTR_DATA(current);
+            return true;
+        }
+        attrs += NLA_ALIGN(current->nla_len);
+        remaining -= NLA_ALIGN(current->nla_len);
+    }
+    return false;
 }
 
-// Build a process tree (parent -> children mapping)
-map<int, vector<int>> buildProcessTree() {
-    map<int, vector<int>> tree;
-    vector<Process> processes = getAllProcesses();
+// Open the generic netlink socket and register for exit records on all CPUs
+bool ExitedProcessMonitor::start(string& error) {
+    if (running) return true;
+    
+    netlink_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+    if (netlink_fd == -1) {
+        error = string("netlink: ") + strerror(errno);
+        return false;
+    }
     
-    // Build the tree
-    for (const auto& proc : processes) {
-        if (proc.ppid > 0) {
-            tree[proc.ppid].push_back(proc.pid);
+    // Bursts of exits (a parallel build finishing) must not overflow the socket
+    int buffer_size = 4 * 1024 * 1024;
+    setsockopt(netlink_fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    
+    struct sockaddr_nl local;
+    memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    if (bind(netlink_fd, (struct sockaddr*)&local, sizeof(local)) == -1 || !resolveFamily()) {
+        error = "taskstats is not available in this kernel";
+        close(netlink_fd);
+        netlink_fd = -1;
+        return false;
+    }
+    
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    cpumask = "0-" + to_string(cpus > 0 ? cpus - 1 : 0);
+    if (!sendCommand(TASKSTATS_CMD_ATTR_REGISTER_CPUMASK, cpumask)) {
+        error = string("taskstats register: ") + strerror(errno);
+        close(netlink_fd);
+        netlink_fd = -1;
+        return false;
+    }
+    
+    // Registration is answered with an error only if it was refused
+    struct pollfd pfd = {netlink_fd, POLLIN, 0};
+    if (poll(&pfd, 1, 100) > 0) {
+        alignas(struct nlmsghdr) char buffer[8192];
+        ssize_t len = recv(netlink_fd, buffer, sizeof(buffer), MSG_PEEK);
+        struct nlmsghdr* msg = (struct nlmsghdr*)buffer;
+        if (len > 0 && NLMSG_OK(msg, (unsigned int)len) && msg->nlmsg_type == NLMSG_ERROR) {
+            struct nlmsgerr* err = (struct nlmsgerr*)NLMSG_DATA(msg);
+            if (err->error != 0) {
+                error = string("taskstats register: ") + strerror(-err->error);
+                close(netlink_fd);
+                netlink_fd = -1;
+                return false;
+            }
         }
     }
     
-    return tree;
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd == -1) {
+        error = string("eventfd: ") + strerror(errno);
+        close(netlink_fd);
+        netlink_fd = -1;
+        return false;
+    }
+    
+    running = true;
+    worker = thread(&ExitedProcessMonitor::run, this);
+    return true;
+}
+
+void ExitedProcessMonitor::stop() {
+    if (!running) return;
+    running = false;
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        // Thread still exits on the next record
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    sendCommand(TASKSTATS_CMD_ATTR_DEREGISTER_CPUMASK, cpumask);
+    close(netlink_fd);
+    close(wake_fd);
+    netlink_fd = -1;
+    wake_fd = -1;
+    pending.clear();
+}
+
+void ExitedProcessMonitor::run() {
+    struct pollfd fds[2];
+    fds[0].fd = netlink_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wake_fd;
+    fds[1].events = POLLIN;
+    
+    alignas(struct nlmsghdr) char buffer[65536];
+    while (running) {
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents & POLLIN) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+        
+        ssize_t len = recv(netlink_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (len == -1) {
+            if (errno == ENOBUFS) lost_events++;   // Records dropped by the kernel
+            continue;
+        }
+        for (struct nlmsghdr* msg = (struct nlmsghdr*)buffer; NLMSG_OK(msg, (unsigned int)len); msg = NLMSG_NEXT(msg, len)) {
+            handleMessage(msg);
+        }
+    }
 }
 
-// Get all child processes of a given PID
-vector<Process> getProcessChildren(int pid) {
-    vector<Process> children;
-    map<int, vector<int>> tree = buildProcessTree();
+// A TASKSTATS_CMD_NEW message holds an AGGR_PID attribute with the stats
+// of the exiting task (and an AGGR_TGID one we do not need: the group
+// totals it carries cover delay accounting only)
+void ExitedProcessMonitor::handleMessage(const struct nlmsghdr* msg) {
+    if (msg->nlmsg_type != family_id) return;
     
-    // If this process has no children, return empty vector
-    if (tree.find(pid) == tree.end()) {
-        return children;
+    char* attrs = (char*)NLMSG_DATA(msg) + GENL_HDRLEN;
+    int remaining = msg->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    while (remaining >= NLA_HDRLEN) {
+        struct nlattr* attr = (struct nlattr*)attrs;
+        if (attr->nla_len < NLA_HDRLEN || attr->nla_len > remaining) break;
+        
+        if ((attr->nla_type & NLA_TYPE_MASK) == TASKSTATS_TYPE_AGGR_PID) {
+            char* nested = GENL_ATTR_DATA(attr);
+            int nested_remaining = GENL_ATTR_PAYLOAD(attr);
+            while (nested_remaining >= NLA_HDRLEN) {
+                struct nlattr* inner = (struct nlattr*)nested;
+                if (inner->nla_len < NLA_HDRLEN || inner->nla_len > nested_remaining) break;
+                if (inner->nla_type == TASKSTATS_TYPE_STATS) {
+                    // The struct grows with kernel versions, copy what both sides know
+                    struct taskstats stats;
+                    memset(&stats, 0, sizeof(stats));
+                    memcpy(&stats, GENL_ATTR_DATA(inner), min((size_t)GENL_ATTR_PAYLOAD(inner), sizeof(stats)));
+                    handleTaskExit(stats);
+                }
+                nested += NLA_ALIGN(inner->nla_len);
+                nested_remaining -= NLA_ALIGN(inner->nla_len);
+            }
+        }
+        attrs += NLA_ALIGN(attr->nla_len);
+        remaining -= NLA_ALIGN(attr->nla_len);
     }
+}
+
+// Fold one task's record into its thread group; the group is complete when
+// the record flagged AGROUP (last task of the process) arrives
+void ExitedProcessMonitor::handleTaskExit(const struct taskstats& stats) {
+    // ac_tgid exists from version 12 on; before that every task stands alone
+    int tgid = stats.version >= 12 && stats.ac_tgid ? (int)stats.ac_tgid : (int)stats.ac_pid;
+    bool last_task = stats.version < 12 || (stats.ac_flag & AGROUP);
     
-    // Get all processes
-    vector<Process> all_processes = getAllProcesses();
-    map<int, Process> pid_to_process;
-    for (const auto& proc : all_processes) {
-        pid_to_process[proc.pid] = proc;
+    ExitedProcess& process = pending[tgid];
+    if (process.threads == 0) {
+        process.pid = tgid;
+        process.max_rss_kb = 0;
+        process.user_sec = process.system_sec = 0.0;
+        process.read_bytes = process.write_bytes = 0;
     }
+    process.threads++;
+    process.user_sec += stats.ac_utime / 1e6;
+    process.system_sec += stats.ac_stime / 1e6;
+    process.max_rss_kb = max(process.max_rss_kb, (unsigned long long)stats.hiwater_rss);
+    process.read_bytes += stats.read_bytes;
+    process.write_bytes += stats.write_bytes;
     
-    // Add direct children
-    for (int child_pid : tree[pid]) {
-        if (pid_to_process.find(child_pid) != pid_to_process.end()) {
-            children.push_back(pid_to_process[child_pid]);
+    if (!last_task) {
+        if ((int)pending.size() > MAX_PENDING) {
+            // Thread-heavy processes that never exit; forget the partial sums
+            pending.clear();
         }
+        return;
     }
     
-    return children;
+    // Identity and lifetime come from the last task
+    process.ppid = stats.ac_ppid;
+    process.uid = stats.ac_uid;
+    process.exit_code = stats.ac_exitcode;
+    memcpy(process.name, stats.ac_comm, TS_COMM_LEN);
+    process.name[TS_COMM_LEN] = '\0';
+    process.wall_sec = (stats.version >= 12 && stats.ac_tgetime ? stats.ac_tgetime : stats.ac_etime) / 1e6;
+    process.exit_time = chrono::steady_clock::now();
+    
+    record(process);
+    pending.erase(tgid);
+}
+
+void ExitedProcessMonitor::record(const ExitedProcess& process) {
+    lock_guard<mutex> guard(lock);
+    ring[ring_next] = process;
+    ring_next = (ring_next + 1) % RING_CAPACITY;
+    if (ring_count < RING_CAPACITY) ring_count++;
+    total_exited++;
+}
+
+void ExitedProcessMonitor::recent(float seconds, vector<ExitedProcess>& out) const {
+    out.clear();
+    chrono::steady_clock::time_point cutoff = chrono::steady_clock::now() - chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float>(seconds));
+    
+    lock_guard<mutex> guard(lock);
+    for (size_t i = 0; i < ring_count; i++) {
+        const ExitedProcess& process = ring[(ring_next + RING_CAPACITY - 1 - i) % RING_CAPACITY];
+        if (process.exit_time < cutoff) break;
+        out.push_back(process);
+    }
+}
+
+// Pss, Private_Clean, Private_Dirty and SwapPss of one process, in bytes
+bool readSmapsRollup(int pid, SmapsRollup& rollup) {
+    char path[40];
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    char buffer[2048];
+    ssize_t len = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (len <= 0) return false;   // Kernel threads have no mm
+    buffer[len] = '\0';
+    
+    rollup.pss = rollup.uss = rollup.swap_pss = 0;
+    for (char* line = buffer; line && *line; ) {
+        char* next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        char* colon = strchr(line, ':');
+        if (colon) {
+            *colon = '\0';
+            unsigned long long kb = strtoull(colon + 1, nullptr, 10);
+            if (strcmp(line, "Pss") == 0) rollup.pss = kb * 1024;
+            else if (strcmp(line, "Private_Clean") == 0 || strcmp(line, "Private_Dirty") == 0) rollup.uss += kb * 1024;
+            else if (strcmp(line, "SwapPss") == 0) rollup.swap_pss = kb * 1024;
+        }
+        line = next;
+    }
+    return true;
+}
+
+static double threadCpuSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+SmapsSampler::SmapsSampler()
+    : running(false), interval(5.0f), cpu_budget(0.02f), last_pass_seconds(0.0f), last_pass_cpu(0.0f) {}
+
+SmapsSampler::~SmapsSampler() {
+    stop();
+}
+
+void SmapsSampler::start() {
+    lock_guard<mutex> guard(lock);
+    if (running) return;
+    running = true;
+    worker = thread(&SmapsSampler::run, this);
+}
+
+void SmapsSampler::stop() {
+    {
+        lock_guard<mutex> guard(lock);
+        if (!running) return;
+        running = false;
+        results.clear();
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+bool SmapsSampler::isRunning() const {
+    lock_guard<mutex> guard(lock);
+    return running;
+}
+
+void SmapsSampler::setInterval(float seconds) {
+    lock_guard<mutex> guard(lock);
+    interval = max(seconds, 0.5f);
+}
+
+void SmapsSampler::setCpuBudget(float fraction) {
+    lock_guard<mutex> guard(lock);
+    cpu_budget = min(max(fraction, 0.001f), 1.0f);
+}
+
+void SmapsSampler::setTargets(const vector<pair<int, unsigned long long>>& new_targets) {
+    lock_guard<mutex> guard(lock);
+    bool first = targets.empty();
+    targets = new_targets;
+    if (first) wake.notify_all();
+}
+
+void SmapsSampler::apply(vector<Process>& processes) const {
+    lock_guard<mutex> guard(lock);
+    for (auto& proc : processes) {
+        auto it = results.find(proc.pid);
+        if (it == results.end() || it->second.start_time != proc.start_time) continue;
+        proc.smaps_sampled = true;
+        proc.pss = it->second.pss;
+        proc.uss = it->second.uss;
+        proc.swap_pss = it->second.swap_pss;
+    }
+}
+
+float SmapsSampler::lastPassSeconds() const {
+    lock_guard<mutex> guard(lock);
+    return last_pass_seconds;
+}
+
+// Averaged over the pass and the idle time up to the next one
+float SmapsSampler::cpuUsage() const {
+    lock_guard<mutex> guard(lock);
+    float cycle = max(last_pass_seconds, interval);
+    return cycle > 0.0f ? last_pass_cpu / cycle : 0.0f;
+}
+
+void SmapsSampler::run() {
+    unique_lock<mutex> guard(lock);
+    while (running) {
+        wake.wait(guard, [this] { return !running || !targets.empty(); });
+        if (!running) break;
+        
+        vector<pair<int, unsigned long long>> pass = targets;
+        auto pass_start = chrono::steady_clock::now();
+        double cpu_start = threadCpuSeconds();
+        unordered_map<int, SmapsRollup> fresh;
+        
+        for (const auto& target : pass) {
+            float budget = cpu_budget;
+            guard.unlock();
+            SmapsRollup rollup;
+            bool ok = readSmapsRollup(target.first, rollup);
+            rollup.start_time = target.second;
+            
+            // Sleep off any CPU spent beyond the budget so far this pass
+            double spent = threadCpuSeconds() - cpu_start;
+            double wall = chrono::duration<double>(chrono::steady_clock::now() - pass_start).count();
+            double ahead = spent / budget - wall;
+            guard.lock();
+            if (!running) break;
+            if (ok) {
+                fresh[target.first] = rollup;
+                results[target.first] = rollup;   // Visible before the pass ends
+            }
+            if (ahead > 0.0) {
+                wake.wait_for(guard, chrono::duration<double>(ahead), [this] { return !running; });
+                if (!running) break;
+            }
+        }
+        if (!running) break;
+        
+        // Drop processes that were not seen this pass
+        results.swap(fresh);
+        last_pass_seconds = chrono::duration<float>(chrono::steady_clock::now() - pass_start).count();
+        last_pass_cpu = (float)(threadCpuSeconds() - cpu_start);
+        
+        auto next_pass = pass_start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float>(interval));
+        wake.wait_until(guard, next_pass, [this] { return !running; });
+    }
+}
+
+// Subscribe to the process connector multicast group
+bool ProcessConnector::open(string& error) {
+    if (netlink_fd >= 0) return true;
+    
+    netlink_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (netlink_fd == -1) {
+        error = string("netlink: ") + strerror(errno);
+        return false;
+    }
+    
+    // Fork storms must not overflow the socket between two samples
+    int buffer_size = 4 * 1024 * 1024;
+    setsockopt(netlink_fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    
+    struct sockaddr_nl local;
+    memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    local.nl_groups = CN_IDX_PROC;
+    if (bind(netlink_fd, (struct sockaddr*)&local, sizeof(local)) == -1 || !subscribe(PROC_CN_MCAST_LISTEN)) {
+        error = string("process connector: ") + strerror(errno);
+        ::close(netlink_fd);
+        netlink_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void ProcessConnector::close() {
+    if (netlink_fd < 0) return;
+    subscribe(PROC_CN_MCAST_IGNORE);
+    ::close(netlink_fd);
+    netlink_fd = -1;
+}
+
+bool ProcessConnector::subscribe(enum proc_cn_mcast_op op) {
+    alignas(struct nlmsghdr) char request[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(op))];
+    memset(request, 0, sizeof(request));
+    struct nlmsghdr* header = (struct nlmsghdr*)request;
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(op));
+    header->nlmsg_type = NLMSG_DONE;
+    struct cn_msg* message = (struct cn_msg*)NLMSG_DATA(header);
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(op);
+    memcpy(message->data, &op, sizeof(op));
+    return send(netlink_fd, request, header->nlmsg_len, 0) != -1;
+}
+
+// New processes arrive as forks whose child is a thread group leader,
+// ended ones as exits of a leader; thread events are ignored
+bool ProcessConnector::drain(unordered_set<int>& pids) {
+    alignas(struct nlmsghdr) char buffer[16384];
+    while (true) {
+        ssize_t len = recv(netlink_fd, buffer, sizeof(buffer), 0);
+        if (len == -1) {
+            if (errno == EINTR) continue;
+            return errno != ENOBUFS;   // EAGAIN: drained
+        }
+        
+        for (struct nlmsghdr* msg = (struct nlmsghdr*)buffer; NLMSG_OK(msg, (unsigned int)len); msg = NLMSG_NEXT(msg, len)) {
+            if (msg->nlmsg_type == NLMSG_ERROR || msg->nlmsg_type == NLMSG_NOOP) continue;
+            struct cn_msg* message = (struct cn_msg*)NLMSG_DATA(msg);
+            if (message->id.idx != CN_IDX_PROC || message->len < offsetof(struct proc_event, event_data)) continue;
+            
+            struct proc_event* event = (struct proc_event*)message->data;
+            switch (event->what) {
+                case proc_event::PROC_EVENT_FORK:
+                    if (event->event_data.fork.child_pid == event->event_data.fork.child_tgid) {
+                        pids.insert(event->event_data.fork.child_tgid);
+                    }
+                    break;
+                case proc_event::PROC_EVENT_EXIT:
+                    if (event->event_data.exit.process_pid == event->event_data.exit.process_tgid) {
+                        pids.erase(event->event_data.exit.process_tgid);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+ProcessTable::ProcessTable()
+    : reconciles(0), io_enabled(false), io_top_n(0), generation(0),
+      published(make_shared<ProcessSnapshot>()), running(false), sample_requested(false), interval(1.0f) {
+    // Views may read the placeholder before the first sample lands
+    auto empty = make_shared<ProcessSnapshot>();
+    empty->counts = getProcessCounts(vector<Process>());
+    published = empty;
+    connector.open(connector_error);
+}
+
+ProcessTable::~ProcessTable() {
+    stop();
+}
+
+void ProcessTable::start(float seconds) {
+    lock_guard<mutex> guard(lock);
+    if (running) return;
+    running = true;
+    interval = seconds;
+    worker = thread(&ProcessTable::run, this);
+}
+
+void ProcessTable::stop() {
+    {
+        lock_guard<mutex> guard(lock);
+        if (!running) return;
+        running = false;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void ProcessTable::requestSample() {
+    lock_guard<mutex> guard(lock);
+    sample_requested = true;
+    wake.notify_all();
+}
+
+void ProcessTable::addSampleHook(function<void(const ProcessSnapshot&)> hook) {
+    hooks.push_back(hook);
+}
+
+void ProcessTable::run() {
+    unique_lock<mutex> guard(lock);
+    while (running) {
+        sample_requested = false;
+        pending_patch.clear();        // The full sample re-reads them anyway
+        guard.unlock();
+        sample();
+        guard.lock();
+        
+        // Patches are applied as they arrive until the next full sample is due
+        auto next = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float>(interval));
+        while (wake.wait_until(guard, next, [this] { return !running || sample_requested || !pending_patch.empty(); })) {
+            if (!running || sample_requested) break;
+            vector<int> changed;
+            changed.swap(pending_patch);
+            guard.unlock();
+            applyPatch(changed);
+            guard.lock();
+        }
+    }
+}
+
+// Rebuild the pid set from a full /proc listing
+void ProcessTable::reconcile() {
+    pids.clear();
+    DIR* proc_dir = opendir("/proc");
+    if (proc_dir) {
+        struct dirent* entry;
+        while ((entry = readdir(proc_dir)) != nullptr) {
+            if (isdigit(entry->d_name[0])) {
+                pids.insert(atoi(entry->d_name));
+            }
+        }
+        closedir(proc_dir);
+    }
+    last_reconcile = chrono::steady_clock::now();
+    reconciles++;
+}
+
+void ProcessTable::setMemoryAccounting(bool enabled, float cpu_budget) {
+    smaps_sampler.setCpuBudget(cpu_budget);
+    if (enabled && !smaps_sampler.isRunning()) smaps_sampler.start();
+    else if (!enabled && smaps_sampler.isRunning()) smaps_sampler.stop();
+}
+
+void ProcessTable::setIoSampling(bool enabled, int top_n, const set<int>& requested) {
+    lock_guard<mutex> guard(lock);
+    io_enabled = enabled;
+    io_top_n = top_n;
+    io_pids = requested;
+}
+
+void ProcessTable::sample() {
+    lock_guard<mutex> sampling(sample_lock);
+    
+    // Keep the pid set current; fall back to a full scan when events may
+    // have been missed or no connector is available
+    bool in_sync = connector.isOpen() && connector.drain(pids);
+    float since_reconcile = chrono::duration<float>(chrono::steady_clock::now() - last_reconcile).count();
+    if (!in_sync || reconciles == 0 || since_reconcile >= RECONCILE_INTERVAL) {
+        reconcile();
+    }
+    
+    shared_ptr<ProcessSnapshot> next = make_shared<ProcessSnapshot>();
+    next->processes.reserve(pids.size());
+    unsigned long total_ram = getMemoryInfo().total_ram;
+    for (auto it = pids.begin(); it != pids.end(); ) {
+        Process proc = getProcessInfo(*it, total_ram);
+        if (proc.name.empty()) {
+            it = pids.erase(it);   // Exit we did not hear about
+            continue;
+        }
+        next->processes.push_back(proc);
+        ++it;
+    }
+    updateProcessCpuUsage(next->processes);
+    
+    bool sample_io;
+    int top_n;
+    set<int> wanted;
+    {
+        lock_guard<mutex> guard(lock);
+        sample_io = io_enabled;
+        top_n = io_top_n;
+        wanted = io_pids;
+    }
+    if (sample_io) {
+        vector<const Process*> by_cpu;
+        by_cpu.reserve(next->processes.size());
+        for (const auto& proc : next->processes) by_cpu.push_back(&proc);
+        size_t n = min((size_t)top_n, by_cpu.size());
+        partial_sort(by_cpu.begin(), by_cpu.begin() + n, by_cpu.end(),
+                     [](const Process* a, const Process* b) { return a->cpu_usage > b->cpu_usage; });
+        for (size_t i = 0; i < n; i++) wanted.insert(by_cpu[i]->pid);
+        io_sampler.sample(next->processes, wanted);
+    }
+    
+    if (smaps_sampler.isRunning()) {
+        vector<pair<int, unsigned long long>> targets;
+        targets.reserve(next->processes.size());
+        for (const auto& proc : next->processes) targets.emplace_back(proc.pid, proc.start_time);
+        smaps_sampler.setTargets(targets);
+        smaps_sampler.apply(next->processes);
+    }
+    
+    next->counts = getProcessCounts(next->processes);
+    
+    next->lower_names.reserve(next->processes.size());
+    next->pid_strings.reserve(next->processes.size());
+    for (const auto& proc : next->processes) {
+        string lower = proc.name;
+        transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        next->lower_names.push_back(move(lower));
+        next->pid_strings.push_back(to_string(proc.pid));
+    }
+    
+    {
+        lock_guard<mutex> guard(lock);
+        next->generation = ++generation;
+        published = next;
+    }
+    for (const auto& hook : hooks) hook(*next);
+}
+
+shared_ptr<const ProcessSnapshot> ProcessTable::snapshot() const {
+    lock_guard<mutex> guard(lock);
+    return published;
+}
+
+void ProcessTable::patch(const vector<int>& changed) {
+    {
+        lock_guard<mutex> guard(lock);
+        if (running) {
+            pending_patch.insert(pending_patch.end(), changed.begin(), changed.end());
+            wake.notify_all();
+            return;
+        }
+    }
+    applyPatch(changed);
+}
+
+// Republish the current snapshot with the given rows re-read. CPU and I/O
+// rates are kept from the last full sample.
+void ProcessTable::applyPatch(const vector<int>& changed) {
+    lock_guard<mutex> sampling(sample_lock);
+    shared_ptr<const ProcessSnapshot> current = snapshot();
+    shared_ptr<ProcessSnapshot> next = make_shared<ProcessSnapshot>(*current);
+    unordered_set<int> wanted(changed.begin(), changed.end());
+    unsigned long total_ram = getMemoryInfo().total_ram;
+    
+    size_t kept = 0;
+    for (size_t i = 0; i < next->processes.size(); i++) {
+        Process& proc = next->processes[i];
+        if (wanted.count(proc.pid)) {
+            Process fresh = getProcessInfo(proc.pid, total_ram);
+            if (fresh.name.empty() || fresh.start_time != proc.start_time) {
+                // A reused pid belongs to a new process the next sample picks up
+                if (fresh.name.empty()) pids.erase(proc.pid);
+                continue;
+            }
+            proc.state = fresh.state;
+            proc.priority = fresh.priority;
+            proc.rss = fresh.rss;
+            proc.vsize = fresh.vsize;
+            proc.memory_usage = fresh.memory_usage;
+        }
+        if (kept != i) {
+            next->processes[kept] = move(proc);
+            next->lower_names[kept] = move(next->lower_names[i]);
+            next->pid_strings[kept] = move(next->pid_strings[i]);
+        }
+        kept++;
+    }
+    next->processes.resize(kept);
+    next->lower_names.resize(kept);
+    next->pid_strings.resize(kept);
+    next->counts = getProcessCounts(next->processes);
+    
+    lock_guard<mutex> guard(lock);
+    next->generation = ++generation;
+    published = next;
+}
+
+// Read the storage counters of one process. Needs ptrace access, so other
+// users' processes fail unless running as root.
+bool readProcessIo(int pid, ProcessIoCounters& counters) {
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/io", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    char buffer[512];
+    ssize_t len = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (len <= 0) return false;
+    buffer[len] = '\0';
+    
+    memset(&counters, 0, sizeof(counters));
+    int found = 0;
+    for (char* line = buffer; line && *line; ) {
+        char* next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        char* colon = strchr(line, ':');
+        if (colon) {
+            *colon = '\0';
+            unsigned long long value = strtoull(colon + 1, nullptr, 10);
+            if (strcmp(line, "read_bytes") == 0) { counters.read_bytes = value; found++; }
+            else if (strcmp(line, "write_bytes") == 0) { counters.write_bytes = value; found++; }
+            else if (strcmp(line, "syscr") == 0) { counters.syscr = value; found++; }
+            else if (strcmp(line, "syscw") == 0) { counters.syscw = value; found++; }
+        }
+        line = next;
+    }
+    return found == 4;
+}
+
+void ProcessIoSampler::sample(vector<Process>& processes, const set<int>& pids) {
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    generation++;
+    
+    for (auto& proc : processes) {
+        if (pids.find(proc.pid) == pids.end()) continue;
+        
+        ProcessIoCounters counters;
+        if (!readProcessIo(proc.pid, counters)) continue;
+        
+        proc.io_sampled = true;
+        proc.io_read_bytes = counters.read_bytes;
+        proc.io_write_bytes = counters.write_bytes;
+        proc.io_syscr = counters.syscr;
+        proc.io_syscw = counters.syscw;
+        
+        auto it = previous.find(proc.pid);
+        if (it != previous.end()) {
+            double elapsed = chrono::duration<double>(now - it->second.time).count();
+            // Counters going backwards means the pid was reused
+            if (elapsed > 0 && counters.read_bytes >= it->second.counters.read_bytes &&
+                counters.write_bytes >= it->second.counters.write_bytes) {
+                proc.io_read_rate = (float)((counters.read_bytes - it->second.counters.read_bytes) / elapsed);
+                proc.io_write_rate = (float)((counters.write_bytes - it->second.counters.write_bytes) / elapsed);
+            }
+        }
+        previous[proc.pid] = {counters, now, generation};
+    }
+    
+    // Forget pids that have not been asked for in a while
+    for (auto it = previous.begin(); it != previous.end(); ) {
+        if (generation - it->second.generation > 60) it = previous.erase(it);
+        else ++it;
+    }
+}
+
+// Field 22 of /proc/[pid]/stat, 0 if the process is gone
+unsigned long long readProcessStartTime(int pid) {
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return 0;
+    char buffer[1024];
+    ssize_t len = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (len <= 0) return 0;
+    buffer[len] = '\0';
+    
+    // The name may contain spaces and parentheses, fields start after the last ')'
+    const char* field = strrchr(buffer, ')');
+    if (!field) return 0;
+    for (int skipped = 0; skipped < 20 && field; skipped++) {
+        field = strchr(field + 1, ' ');
+    }
+    return field ? strtoull(field + 1, nullptr, 10) : 0;
+}
+
+// Every pid in a cgroup and the groups below it
+static void collectCgroupTargets(const string& dir, vector<ProcessActionTarget>& targets) {
+    ifstream procs(dir + "/cgroup.procs");
+    int pid;
+    while (procs >> pid) {
+        targets.push_back({pid, 0, getProcessName(pid)});
+    }
+    
+    DIR* groups = opendir(dir.c_str());
+    if (!groups) return;
+    struct dirent* entry;
+    while ((entry = readdir(groups)) != nullptr) {
+        if (entry->d_type == DT_DIR && entry->d_name[0] != '.') {
+            collectCgroupTargets(dir + "/" + entry->d_name, targets);
+        }
+    }
+    closedir(groups);
+}
+
+ProcessActionRunner::ProcessActionRunner() : running(false), executing(false), next_batch(0) {}
+
+ProcessActionRunner::~ProcessActionRunner() {
+    {
+        lock_guard<mutex> guard(lock);
+        if (!running) return;
+        running = false;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+// Called with the lock held
+void ProcessActionRunner::start() {
+    if (running) return;
+    running = true;
+    worker = thread(&ProcessActionRunner::run, this);
+}
+
+unsigned long ProcessActionRunner::submit(int signal, const vector<ProcessActionTarget>& targets) {
+    lock_guard<mutex> guard(lock);
+    start();
+    queue.push_back({++next_batch, signal, targets, ""});
+    wake.notify_one();
+    return next_batch;
+}
+
+unsigned long ProcessActionRunner::submitCgroup(int signal, const string& cgroup_dir) {
+    lock_guard<mutex> guard(lock);
+    start();
+    queue.push_back({++next_batch, signal, {}, cgroup_dir});
+    wake.notify_one();
+    return next_batch;
+}
+
+void ProcessActionRunner::collect(vector<ProcessActionResult>& results) {
+    results.clear();
+    lock_guard<mutex> guard(lock);
+    results.swap(finished);
+}
+
+bool ProcessActionRunner::busy() const {
+    lock_guard<mutex> guard(lock);
+    return executing || !queue.empty();
+}
+
+// The cgroup v2 directory of a process, from the "0::" line of /proc/[pid]/cgroup
+string ProcessActionRunner::cgroupOf(int pid, const string& cgroup_root) {
+    if (cgroup_root.empty()) return "";
+    ifstream file("/proc/" + to_string(pid) + "/cgroup");
+    string line;
+    while (getline(file, line)) {
+        if (line.compare(0, 3, "0::") == 0) {
+            string path = line.substr(3);
+            return path == "/" ? cgroup_root : cgroup_root + path;
+        }
+    }
+    return "";
+}
+
+void ProcessActionRunner::run() {
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [this] { return !running || !queue.empty(); });
+        if (!running) break;
+        
+        Batch batch = move(queue.front());
+        queue.pop_front();
+        executing = true;
+        
+        guard.unlock();
+        vector<ProcessActionResult> results;
+        execute(batch, results);
+        guard.lock();
+        
+        executing = false;
+        finished.insert(finished.end(), results.begin(), results.end());
+    }
+}
+
+void ProcessActionRunner::execute(Batch& batch, vector<ProcessActionResult>& results) {
+    if (!batch.cgroup_dir.empty()) {
+        collectCgroupTargets(batch.cgroup_dir, batch.targets);
+    }
+    
+    // Pin every target first, so the whole batch refers to the processes
+    // that existed when it started
+    size_t count = batch.targets.size();
+    vector<int> pidfds(count, -1);
+    results.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const ProcessActionTarget& target = batch.targets[i];
+        results[i] = {batch.id, target.pid, target.name, 0, false};
+        pidfds[i] = (int)syscall(SYS_pidfd_open, target.pid, 0);
+        if (pidfds[i] == -1) {
+            results[i].error = errno;
+        } else if (target.start_time != 0 && readProcessStartTime(target.pid) != target.start_time) {
+            results[i].error = ESRCH;   // Same pid, different process
+            close(pidfds[i]);
+            pidfds[i] = -1;
+        }
+    }
+    
+    bool group_killed = false;
+    if (!batch.cgroup_dir.empty() && batch.signal == SIGKILL) {
+        int fd = open((batch.cgroup_dir + "/cgroup.kill").c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd != -1) {
+            group_killed = write(fd, "1", 1) == 1;
+            close(fd);
+        }
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (pidfds[i] != -1) {
+            if (!group_killed && syscall(SYS_pidfd_send_signal, pidfds[i], batch.signal, nullptr, 0) == -1) {
+                results[i].error = errno;
+            }
+        } else if (results[i].error == ENOSYS) {
+            // Kernel older than 5.3, accept the pid reuse race
+            results[i].error = kill(results[i].pid, batch.signal) == 0 ? 0 : errno;
+        }
+    }
+    
+    // For signals that normally end a process, wait briefly for the
+    // pidfds to report the exit
+    bool fatal = batch.signal == SIGKILL || batch.signal == SIGTERM || batch.signal == SIGINT ||
+                 batch.signal == SIGHUP || batch.signal == SIGQUIT;
+    vector<struct pollfd> waiting;
+    vector<size_t> waiting_index;
+    for (size_t i = 0; i < count; i++) {
+        if (fatal && pidfds[i] != -1 && results[i].error == 0) {
+            waiting.push_back({pidfds[i], POLLIN, 0});
+            waiting_index.push_back(i);
+        }
+    }
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(EXIT_WAIT_MS);
+    size_t remaining = waiting.size();
+    while (remaining > 0) {
+        int timeout = (int)chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+        if (timeout <= 0) break;
+        int ready = poll(waiting.data(), waiting.size(), timeout);
+        if (ready == -1 && errno != EINTR) break;
+        for (size_t w = 0; w < waiting.size() && ready > 0; w++) {
+            if (waiting[w].fd >= 0 && waiting[w].revents) {
+                results[waiting_index[w]].exited = true;
+                waiting[w].fd = -1;   // poll() skips negative fds
+                remaining--;
+            }
+        }
+    }
+    
+    for (int fd : pidfds) {
+        if (fd != -1) close(fd);
+    }
+}
+
+// Kill a process by PID
+bool killProcess(int pid) {
+    if (pid <= 0) return false;
+    return (kill(pid, SIGTERM) == 0);
+}
+
+// Rebuild the tree for a new snapshot: children are bucketed by parent
+// in pid order, rows whose parent is missing become roots, a stack walk
+// lays out the preorder and a reverse pass over it sums the subtrees
+void ProcessTree::update(const shared_ptr<const ProcessSnapshot>& snapshot) {
+    if (!snapshot || (source && snapshot->generation == generation)) return;
+    source = snapshot;
+    generation = snapshot->generation;
+    
+    const vector<Process>& processes = snapshot->processes;
+    int rows = (int)processes.size();
+    
+    by_pid.resize(rows);
+    for (int i = 0; i < rows; i++) by_pid[i] = i;
+    sort(by_pid.begin(), by_pid.end(), [&](int a, int b) { return processes[a].pid < processes[b].pid; });
+    
+    // Parent row of every row, -1 for roots
+    vector<int> parent(rows);
+    child_offsets.assign(rows + 1, 0);
+    for (int i = 0; i < rows; i++) {
+        parent[i] = processes[i].ppid != processes[i].pid ? find(processes[i].ppid) : -1;
+        if (parent[i] >= 0) child_offsets[parent[i] + 1]++;
+    }
+    for (int i = 0; i < rows; i++) child_offsets[i + 1] += child_offsets[i];
+    
+    child_rows.resize(child_offsets[rows]);
+    vector<int> fill(child_offsets.begin(), child_offsets.end() - 1);
+    vector<int> roots;
+    for (int row : by_pid) {
+        if (parent[row] >= 0) child_rows[fill[parent[row]]++] = row;
+        else roots.push_back(row);
+    }
+    
+    preorder.clear();
+    preorder.reserve(rows);
+    depth.assign(rows, 0);
+    vector<int> stack(roots.rbegin(), roots.rend());
+    while (!stack.empty()) {
+        int row = stack.back();
+        stack.pop_back();
+        preorder.push_back(row);
+        for (const int* child = childrenEnd(row); child != childrenBegin(row); ) {
+            --child;
+            depth[*child] = depth[row] + 1;
+            stack.push_back(*child);
+        }
+    }
+    
+    subtree_size.assign(rows, 1);
+    subtree_cpu.resize(rows);
+    subtree_memory.resize(rows);
+    for (int i = 0; i < rows; i++) {
+        subtree_cpu[i] = processes[i].cpu_usage;
+        subtree_memory[i] = processes[i].memory_usage;
+    }
+    for (auto it = preorder.rbegin(); it != preorder.rend(); ++it) {
+        int up = parent[*it];
+        if (up < 0) continue;
+        subtree_size[up] += subtree_size[*it];
+        subtree_cpu[up] += subtree_cpu[*it];
+        subtree_memory[up] += subtree_memory[*it];
+    }
+}
+
+int ProcessTree::find(int pid) const {
+    const vector<Process>& processes = source->processes;
+    auto it = lower_bound(by_pid.begin(), by_pid.end(), pid,
+                          [&](int row, int value) { return processes[row].pid < value; });
+    return (it != by_pid.end() && processes[*it].pid == pid) ? *it : -1;
+}
+
+void ProcessTree::subtree(int row, vector<int>& rows) const {
+    vector<int> stack(1, row);
+    while (!stack.empty()) {
+        int next = stack.back();
+        stack.pop_back();
+        rows.push_back(next);
+        stack.insert(stack.end(), childrenBegin(next), childrenEnd(next));
+    }
+}
+
+void ProcessSortIndex::update(const shared_ptr<const ProcessSnapshot>& snapshot, ProcessSortColumn new_column, bool new_ascending,
+                              const ProcessFilter* filter) {
+    if (!snapshot) return;
+    unsigned long new_filter_revision = filter ? filter->revision : 0;
+    if (source && snapshot->generation == generation && new_column == column && new_ascending == ascending &&
+        new_filter_revision == filter_revision) return;
+    
+    source = snapshot;
+    generation = snapshot->generation;
+    column = new_column;
+    ascending = new_ascending;
+    filter_revision = new_filter_revision;
+    
+    size_t rows = source->processes.size();
+    order.clear();
+    if (filter && !filter->empty()) {
+        for (size_t i = 0; i < rows; i++) {
+            if (filter->matches(*source, i)) order.push_back((int)i);
+        }
+    } else {
+        order.resize(rows);
+        for (size_t i = 0; i < rows; i++) order[i] = (int)i;
+    }
+    sorted = 0;
+}
+
+// One comparator per column, picked once per sort rather than per comparison
+namespace {
+
+template <typename Key>
+struct ProcessRowLess {
+    const vector<Process>& rows;
+    bool ascending;
+    
+    bool operator()(int a, int b) const {
+        const Process& x = rows[a];
+        const Process& y = rows[b];
+        if (Key::less(x, y)) return ascending;
+        if (Key::less(y, x)) return !ascending;
+        return x.pid < y.pid;
+    }
+};
+
+struct PidKey { static bool less(const Process& x, const Process& y) { return x.pid < y.pid; } };
+struct NameKey { static bool less(const Process& x, const Process& y) { return x.name < y.name; } };
+struct StateKey { static bool less(const Process& x, const Process& y) { return x.state < y.state; } };
+struct CpuKey { static bool less(const Process& x, const Process& y) { return x.cpu_usage < y.cpu_usage; } };
+struct MemoryKey { static bool less(const Process& x, const Process& y) { return x.memory_usage < y.memory_usage; } };
+struct IoReadKey { static bool less(const Process& x, const Process& y) { return x.io_read_rate < y.io_read_rate; } };
+struct IoWriteKey { static bool less(const Process& x, const Process& y) { return x.io_write_rate < y.io_write_rate; } };
+struct PssKey { static bool less(const Process& x, const Process& y) { return x.pss < y.pss; } };
+struct UssKey { static bool less(const Process& x, const Process& y) { return x.uss < y.uss; } };
+struct SwapPssKey { static bool less(const Process& x, const Process& y) { return x.swap_pss < y.swap_pss; } };
+
+template <typename Key>
+void sortRows(vector<int>& order, size_t from, size_t to, const vector<Process>& rows, bool ascending) {
+    ProcessRowLess<Key> less{rows, ascending};
+    if (to == order.size()) sort(order.begin() + from, order.end(), less);
+    else partial_sort(order.begin() + from, order.begin() + to, order.end(), less);
+}
+
+}
+
+size_t ProcessSortIndex::sortedPrefix(size_t n) {
+    n = min(n, order.size());
+    if (n <= sorted) return n;
+    
+    // Asking for most of the table costs little more than sorting all of it
+    size_t to = n > order.size() / 2 ? order.size() : n;
+    const vector<Process>& rows = source->processes;
+    switch (column) {
+        case PROCESS_SORT_PID: sortRows<PidKey>(order, sorted, to, rows, ascending); break;
+        case PROCESS_SORT_NAME: sortRows<NameKey>(order, sorted, to, rows, ascending); break;
+        case PROCESS_SORT_STATE: sortRows<StateKey>(order, sorted, to, rows, ascending); break;
+        case PROCESS_SORT_CPU: sortRows<CpuKey>(order, sorted, to, rows, ascending); break;
+        case PROCESS_SORT_MEMORY: sortRows<MemoryKey>(order, sorted, to, rows, ascending); break;
+        case PROCESS_SORT_IO_READ: sortRows<IoReadKey>(order, sorted, to, rows, ascending); break;
+        case PROCESS_SORT_IO_WRITE: sortRows<IoWriteKey>(order, sorted, to, rows, ascending); break;
+        case PROCESS_SORT_PSS: sortRows<PssKey>(order, sorted, to, rows, ascending); break;
+        case PROCESS_SORT_USS: sortRows<UssKey>(order, sorted, to, rows, ascending); break;
+        case PROCESS_SORT_SWAP_PSS: sortRows<SwapPssKey>(order, sorted, to, rows, ascending); break;
+        default: to = n; break;
+    }
+    sorted = to;
+    return n;
+}
+
+// Split "cpu>=5" into field, comparison and number
+static bool parseFilterComparison(const string& token, ProcessFilterTerm& term) {
+    static const struct { const char* name; ProcessFilterField field; } FIELDS[] = {
+        {"cpu", FILTER_CPU}, {"mem", FILTER_MEMORY}, {"pid", FILTER_PID}
+    };
+    static const struct { const char* op; ProcessFilterCompare compare; } OPERATORS[] = {
+        {"<=", FILTER_LESS_EQUAL}, {">=", FILTER_GREATER_EQUAL}, {"<", FILTER_LESS}, {">", FILTER_GREATER}, {"=", FILTER_EQUAL}
+    };
+    
+    for (const auto& field : FIELDS) {
+        size_t name_len = strlen(field.name);
+        if (token.compare(0, name_len, field.name) != 0) continue;
+        for (const auto& op : OPERATORS) {
+            size_t op_len = strlen(op.op);
+            if (token.compare(name_len, op_len, op.op) != 0) continue;
+            
+            const char* number = token.c_str() + name_len + op_len;
+            char* end;
+            double value = strtod(number, &end);
+            if (end == number || *end != '\0') return false;
+            term.field = field.field;
+            term.compare = op.compare;
+            term.value = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ProcessFilter::compile(const string& query, string& error) {
+    vector<ProcessFilterTerm> compiled;
+    istringstream words(query);
+    string token;
+    while (words >> token) {
+        ProcessFilterTerm term;
+        term.field = FILTER_TEXT;
+        term.negate = false;
+        term.compare = FILTER_EQUAL;
+        term.value = 0.0;
+        term.uid = (uid_t)-1;
+        
+        if (token[0] == '!' && token.size() > 1) {
+            term.negate = true;
+            token.erase(0, 1);
+        }
+        
+        size_t colon = token.find(':');
+        string key = colon == string::npos ? "" : token.substr(0, colon);
+        string value = colon == string::npos ? token : token.substr(colon + 1);
+        if (token.size() > 2 && token.front() == '/' && token.back() == '/') {
+            key = "re";
+            value = token.substr(1, token.size() - 2);
+        }
+        
+        if (key == "re") {
+            try {
+                term.field = FILTER_REGEX;
+                term.pattern = make_shared<regex>(value, regex::icase | regex::optimize);
+            } catch (const regex_error& e) {
+                error = "bad regex '" + value + "': " + e.what();
+                return false;
+            }
+        } else if (key == "name" || key == "cmd") {
+            term.field = key == "name" ? FILTER_NAME : FILTER_COMMAND;
+            term.text = value;
+        } else if (key == "user") {
+            term.field = FILTER_USER;
+            char* end;
+            unsigned long uid = strtoul(value.c_str(), &end, 10);
+            if (!value.empty() && *end == '\0') {
+                term.uid = (uid_t)uid;
+            } else {
+                struct passwd* entry = getpwnam(value.c_str());
+                if (!entry) {
+                    error = "unknown user '" + value + "'";
+                    return false;
+                }
+                term.uid = entry->pw_uid;
+            }
+        } else if (key == "state") {
+            // A single letter is the raw state, anything longer a prefix
+            // of the state name ("run", "zombie", "disk")
+            term.field = FILTER_STATE;
+            if (value.size() == 1) {
+                term.text = value;
+                if (value != "t") term.text += (char)toupper(value[0]);
+            } else {
+                transform(value.begin(), value.end(), value.begin(), ::tolower);
+                Process probe;
+                for (char state : string("RSDTtZXI")) {
+                    probe.state = state;
+                    string state_name = probe.getStateString();
+                    transform(state_name.begin(), state_name.end(), state_name.begin(), ::tolower);
+                    if (!value.empty() && state_name.compare(0, value.size(), value) == 0) term.text += state;
+                }
+                if (value == "idle") term.text += 'I';
+            }
+            if (term.text.empty()) {
+                error = "unknown state '" + value + "'";
+                return false;
+            }
+        } else if (!parseFilterComparison(token, term)) {
+            term.field = FILTER_TEXT;
+            term.text = token;
+        }
+        
+        if (term.field == FILTER_TEXT || term.field == FILTER_NAME || term.field == FILTER_COMMAND) {
+            transform(term.text.begin(), term.text.end(), term.text.begin(), ::tolower);
+        }
+        compiled.push_back(term);
+    }
+    
+    // Cheap terms first; command lines are read on demand
+    stable_partition(compiled.begin(), compiled.end(),
+                     [](const ProcessFilterTerm& term) { return term.field != FILTER_COMMAND; });
+    
+    terms.swap(compiled);
+    revision++;
+    error.clear();
+    return true;
+}
+
+static bool compareFilterValue(double actual, ProcessFilterCompare compare, double expected) {
+    switch (compare) {
+        case FILTER_LESS: return actual < expected;
+        case FILTER_LESS_EQUAL: return actual <= expected;
+        case FILTER_EQUAL: return actual == expected;
+        case FILTER_GREATER_EQUAL: return actual >= expected;
+        case FILTER_GREATER: return actual > expected;
+        default: return false;
+    }
+}
+
+bool ProcessFilter::matches(const ProcessSnapshot& snapshot, size_t row) const {
+    const Process& proc = snapshot.processes[row];
+    for (const auto& term : terms) {
+        bool hit;
+        switch (term.field) {
+            case FILTER_TEXT:
+                hit = snapshot.lower_names[row].find(term.text) != string::npos ||
+                      snapshot.pid_strings[row].find(term.text) != string::npos;
+                break;
+            case FILTER_NAME: hit = snapshot.lower_names[row].find(term.text) != string::npos; break;
+            case FILTER_USER: hit = proc.uid == term.uid; break;
+            case FILTER_STATE: hit = term.text.find(proc.state) != string::npos; break;
+            case FILTER_REGEX: hit = regex_search(proc.name, *term.pattern); break;
+            case FILTER_COMMAND: {
+                if (!commands) { hit = true; break; }
+                hit = commands->getLower(proc).find(term.text) != string::npos;
+                break;
+            }
+            case FILTER_PID: hit = compareFilterValue(proc.pid, term.compare, term.value); break;
+            case FILTER_CPU: hit = compareFilterValue(proc.cpu_usage, term.compare, term.value); break;
+            case FILTER_MEMORY: hit = compareFilterValue(proc.memory_usage, term.compare, term.value); break;
+            default: hit = true; break;
+        }
+        if (hit == term.negate) return false;
+    }
+    return true;
+}
+
+void UserNameCache::load() {
+    names.clear();
+    ifstream passwd("/etc/passwd");
+    string line;
+    while (getline(passwd, line)) {
+        // name:password:uid:...
+        size_t first = line.find(':');
+        if (first == string::npos || first == 0) continue;
+        size_t second = line.find(':', first + 1);
+        if (second == string::npos) continue;
+        char* end;
+        unsigned long uid = strtoul(line.c_str() + second + 1, &end, 10);
+        if (*end != ':') continue;
+        names.emplace((uid_t)uid, line.substr(0, first));   // First entry wins, like getpwuid
+    }
+}
+
+const string& UserNameCache::name(uid_t uid) {
+    auto now = chrono::steady_clock::now();
+    if (loaded_mtime == 0 || chrono::duration<float>(now - last_check).count() >= RELOAD_CHECK_INTERVAL) {
+        last_check = now;
+        struct stat st;
+        time_t mtime = stat("/etc/passwd", &st) == 0 ? st.st_mtime : 1;
+        if (mtime != loaded_mtime) {
+            load();
+            loaded_mtime = mtime;
+        }
+    }
+    
+    auto it = names.find(uid);
+    if (it == names.end()) {
+        it = names.emplace(uid, uid == (uid_t)-1 ? string("?") : to_string(uid)).first;
+    }
+    return it->second;
+}
+
+// Arguments are NUL separated; kernel threads have none and are shown
+// bracketed like ps does
+CommandLineCache::Entry& CommandLineCache::lookup(const Process& proc) {
+    auto it = entries.find(proc.pid);
+    if (it != entries.end() && it->second.start_time == proc.start_time && it->second.name == proc.name &&
+        generation - it->second.fetched < REFRESH_SNAPSHOTS) {
+        return it->second;
+    }
+    
+    Entry entry;
+    entry.start_time = proc.start_time;
+    entry.seen = generation;
+    entry.fetched = generation;
+    entry.name = proc.name;
+    
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/cmdline", proc.pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd != -1) {
+        char buffer[4096];
+        ssize_t len = read(fd, buffer, sizeof(buffer));
+        ::close(fd);
+        if (len > 0) {
+            while (len > 0 && buffer[len - 1] == '\0') len--;
+            for (ssize_t i = 0; i < len; i++) {
+                if (buffer[i] == '\0') buffer[i] = ' ';
+            }
+            entry.command.assign(buffer, len);
+        }
+    }
+    if (entry.command.empty()) {
+        entry.command = "[" + proc.name + "]";
+    }
+    entry.lower_command = entry.command;
+    transform(entry.lower_command.begin(), entry.lower_command.end(), entry.lower_command.begin(), ::tolower);
+    
+    auto& slot = entries[proc.pid];
+    slot = move(entry);
+    return slot;
+}
+
+void CommandLineCache::prune(const ProcessSnapshot& snapshot) {
+    if (snapshot.generation == generation) return;
+    generation = snapshot.generation;
+    
+    for (const auto& proc : snapshot.processes) {
+        auto it = entries.find(proc.pid);
+        if (it != entries.end() && it->second.start_time == proc.start_time) {
+            it->second.seen = generation;
+        }
+    }
+    for (auto it = entries.begin(); it != entries.end(); ) {
+        if (it->second.seen != generation) it = entries.erase(it);
+        else ++it;
+    }
 }
 
 // Get process priority (nice value)
@@ -155,21 +155,248 @@ string getInterfaceType(const string& interface_name) {
     }
 }
 
-// Get network statistics for a specific interface
-NetworkStats getNetworkStats(const string& interface_name) {
-    NetworkStats stats;
-    stats.interface_name = interface_name;
-    stats.rx_bytes = 0;
-    stats.rx_packets = 0;
-    stats.tx_bytes = 0;
-    stats.tx_packets = 0;
-    stats.rx_speed = 0.0f;
-    stats.tx_speed = 0.0f;
+NetlinkInterfaceMonitor::NetlinkInterfaceMonitor()
+    : netlink_fd(-1), wake_fd(-1), sequence(0), model_generation(0), running(false), resync_requested(false) {}
+
+NetlinkInterfaceMonitor::~NetlinkInterfaceMonitor() {
+    stop();
+}
+
+// Open the rtnetlink socket, subscribe to link/address groups and start the monitor thread
+bool NetlinkInterfaceMonitor::start() {
+    if (running) return true;
+    
+    netlink_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (netlink_fd == -1) {
+        return false;
+    }
+    
+    struct sockaddr_nl local;
+    memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    local.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (bind(netlink_fd, (struct sockaddr*)&local, sizeof(local)) == -1) {
+        close(netlink_fd);
+        netlink_fd = -1;
+        return false;
+    }
+    
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd == -1) {
+        close(netlink_fd);
+        netlink_fd = -1;
+        return false;
+    }
+    
+    running = true;
+    resync_requested = true; // Initial dump
+    worker = thread(&NetlinkInterfaceMonitor::run, this);
+    return true;
+}
+
+// Stop the monitor thread and close the sockets
+void NetlinkInterfaceMonitor::stop() {
+    if (!running) return;
+    running = false;
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        // Thread still exits on the next netlink event
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    close(netlink_fd);
+    close(wake_fd);
+    netlink_fd = -1;
+    wake_fd = -1;
+}
+
+// Ask the monitor thread to rebuild the model from a fresh dump
+void NetlinkInterfaceMonitor::requestResync() {
+    if (!running) return;
+    resync_requested = true;
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        // Already signalled
+    }
+}
+
+// Copy the current interface table, returns the generation it corresponds to
+unsigned long NetlinkInterfaceMonitor::snapshot(vector<NetworkInterface>& out) const {
+    lock_guard<mutex> guard(lock);
+    out = published;
+    return model_generation.load();
+}
+
+// Send a dump request (RTM_GETLINK or RTM_GETADDR) and process the reply
+bool NetlinkInterfaceMonitor::dump(int type) {
+    struct {
+        struct nlmsghdr header;
+        struct rtgenmsg body;
+    } request;
+    memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtgenmsg));
+    request.header.nlmsg_type = type;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = ++sequence;
+    request.body.rtgen_family = AF_UNSPEC;
+    
+    if (send(netlink_fd, &request, request.header.nlmsg_len, 0) == -1) {
+        return false;
+    }
+    return receive(request.header.nlmsg_seq);
+}
+
+// Read and apply pending netlink messages. With wait_seq != 0, keep reading
+// until that dump is complete; otherwise read one batch.
+bool NetlinkInterfaceMonitor::receive(unsigned int wait_seq) {
+    alignas(struct nlmsghdr) char buffer[32768];
+    
+    while (true) {
+        ssize_t len = recv(netlink_fd, buffer, sizeof(buffer), 0);
+        if (len == -1) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {
+                // Kernel dropped notifications, the model may be stale
+                resync_requested = true;
+            }
+            return false;
+        }
+        
+        for (struct nlmsghdr* msg = (struct nlmsghdr*)buffer; NLMSG_OK(msg, (unsigned int)len); msg = NLMSG_NEXT(msg, len)) {
+            if (wait_seq != 0 && msg->nlmsg_seq == wait_seq &&
+                (msg->nlmsg_type == NLMSG_DONE || msg->nlmsg_type == NLMSG_ERROR)) {
+                return msg->nlmsg_type == NLMSG_DONE;
+            }
+            handleMessage(msg);
+        }
+        
+        if (wait_seq == 0) return true;
+    }
+}
+
+// Apply one RTM_NEWLINK/DELLINK/NEWADDR/DELADDR message to the model
+void NetlinkInterfaceMonitor::handleMessage(const struct nlmsghdr* msg) {
+    if (msg->nlmsg_type == RTM_NEWLINK || msg->nlmsg_type == RTM_DELLINK) {
+        const struct ifinfomsg* info = (const struct ifinfomsg*)NLMSG_DATA(msg);
+        if (msg->nlmsg_type == RTM_DELLINK) {
+            links.erase(info->ifi_index);
+            return;
+        }
+        
+        Link& link = links[info->ifi_index];
+        link.flags = info->ifi_flags;
+        link.arp_type = info->ifi_type;
+        
+        int attr_len = IFLA_PAYLOAD(msg);
+        for (const struct rtattr* attr = IFLA_RTA(info); RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+            if (attr->rta_type == IFLA_IFNAME) {
+                link.name = (const char*)RTA_DATA(attr);
+            } else if (attr->rta_type == IFLA_ADDRESS) {
+                const unsigned char* bytes = (const unsigned char*)RTA_DATA(attr);
+                int count = RTA_PAYLOAD(attr);
+                string mac;
+                char octet[4];
+                for (int i = 0; i < count; i++) {
+                    snprintf(octet, sizeof(octet), i == 0 ? "%02x" : ":%02x", bytes[i]);
+                    mac += octet;
+                }
+                link.mac_address = mac;
+            }
+        }
+    } else if (msg->nlmsg_type == RTM_NEWADDR || msg->nlmsg_type == RTM_DELADDR) {
+        const struct ifaddrmsg* info = (const struct ifaddrmsg*)NLMSG_DATA(msg);
+        if (info->ifa_family != AF_INET && info->ifa_family != AF_INET6) return;
+        
+        // IFA_LOCAL is the interface address on point-to-point links, IFA_ADDRESS the peer
+        const void* address = nullptr;
+        int attr_len = IFA_PAYLOAD(msg);
+        for (const struct rtattr* attr = IFA_RTA(info); RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+            if (attr->rta_type == IFA_LOCAL || (attr->rta_type == IFA_ADDRESS && address == nullptr)) {
+                address = RTA_DATA(attr);
+            }
+        }
+        if (address == nullptr) return;
+        
+        char address_buffer[INET6_ADDRSTRLEN];
+        inet_ntop(info->ifa_family, address, address_buffer, sizeof(address_buffer));
+        
+        auto it = links.find(info->ifa_index);
+        if (it == links.end()) return;
+        vector<string>& addresses = info->ifa_family == AF_INET ? it->second.ipv4_addresses : it->second.ipv6_addresses;
+        auto existing = find(addresses.begin(), addresses.end(), string(address_buffer));
+        
+        if (msg->nlmsg_type == RTM_NEWADDR && existing == addresses.end()) {
+            addresses.push_back(address_buffer);
+        } else if (msg->nlmsg_type == RTM_DELADDR && existing != addresses.end()) {
+            addresses.erase(existing);
+        }
+    }
+}
+
+// Rebuild the published interface table from the model
+void NetlinkInterfaceMonitor::publish() {
+    vector<NetworkInterface> interfaces;
+    for (const auto& entry : links) {
+        const Link& link = entry.second;
+        NetworkInterface interface;
+        interface.name = link.name;
+        interface.ipv4_address = link.ipv4_addresses.empty() ? "" : link.ipv4_addresses[0];
+        interface.ipv6_address = link.ipv6_addresses.empty() ? "" : link.ipv6_addresses[0];
+        interface.mac_address = link.mac_address;
+        interface.is_up = (link.flags & IFF_UP) && (link.flags & IFF_RUNNING);
+        interface.type = link.arp_type == ARPHRD_LOOPBACK ? "Loopback" : getInterfaceType(link.name);
+        interfaces.push_back(interface);
+    }
+    
+    lock_guard<mutex> guard(lock);
+    published.swap(interfaces);
+    model_generation++;
+}
+
+void NetlinkInterfaceMonitor::run() {
+    struct pollfd fds[2];
+    fds[0].fd = netlink_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wake_fd;
+    fds[1].events = POLLIN;
+    
+    while (running) {
+        if (resync_requested.exchange(false)) {
+            links.clear();
+            dump(RTM_GETLINK);
+            dump(RTM_GETADDR);
+            publish();
+        }
+        
+        // Blocks until the kernel reports a change or we are woken up
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        if (fds[1].revents & POLLIN) {
+            uint64_t value;
+            if (read(wake_fd, &value, sizeof(value)) < 0) {
+                // Spurious wakeup
+            }
+        }
+        
+        if (fds[0].revents & POLLIN) {
+            if (receive(0)) {
+                publish();
+            }
+        }
+    }
+}
+
+// Get network statistics for every interface listed in /proc/net/dev
+vector<NetworkStats> getAllNetworkStats() {
+    vector<NetworkStats> all_stats;
     
-    // Read from /proc/net/dev
     ifstream net_dev("/proc/net/dev");
     if (!net_dev.is_open()) {
-        return stats;
+        return all_stats;
     }
     
     string line;
@@ -177,7 +404,6 @@ NetworkStats getNetworkStats(const string& interface_name) {
     getline(net_dev, line); // Inter-|   Receive                                                |
     getline(net_dev, line); // face |bytes    packets errs drop fifo frame compressed multicast|
     
-    // Find the interface
     while (getline(net_dev, line)) {
         // Remove leading spaces
         line.erase(0, line.find_first_not_of(" \t"));
@@ -186,59 +412,194 @@ NetworkStats getNetworkStats(const string& interface_name) {
         size_t colon_pos = line.find(':');
         if (colon_pos == string::npos) continue;
         
-        string if_name = line.substr(0, colon_pos);
-        if (if_name != interface_name) continue;
+        NetworkStats stats;
+        stats.interface_name = line.substr(0, colon_pos);
+        stats.rx_speed = 0.0f;
+        stats.tx_speed = 0.0f;
         
         // Parse the statistics
-        stringstream ss(line.substr(colon_pos + 1));
-        unsigned long rx_bytes, rx_packets, rx_errs, rx_drop, rx_fifo, rx_frame, rx_compressed, rx_multicast;
-        unsigned long tx_bytes, tx_packets, tx_errs, tx_drop, tx_fifo, tx_colls, tx_carrier, tx_compressed;
-        
-        ss >> rx_bytes >> rx_packets >> rx_errs >> rx_drop >> rx_fifo >> rx_frame >> rx_compressed >> rx_multicast
-           >> tx_bytes >> tx_packets >> tx_errs >> tx_drop >> tx_fifo >> tx_colls >> tx_carrier >> tx_compressed;
+        unsigned long rx_bytes = 0, rx_packets = 0, rx_errs, rx_drop, rx_fifo, rx_frame, rx_compressed, rx_multicast;
+        unsigned long tx_bytes = 0, tx_packets = 0;
+        sscanf(line.c_str() + colon_pos + 1, "%lu %lu %lu %lu %lu %lu %lu %lu %lu %lu",
+               &rx_bytes, &rx_packets, &rx_errs, &rx_drop, &rx_fifo, &rx_frame, &rx_compressed, &rx_multicast,
+               &tx_bytes, &tx_packets);
         
         stats.rx_bytes = rx_bytes;
         stats.rx_packets = rx_packets;
         stats.tx_bytes = tx_bytes;
         stats.tx_packets = tx_packets;
-        
-        break;
+        all_stats.push_back(stats);
     }
     
+    return all_stats;
+}
+
+// Get network statistics for a specific interface
+NetworkStats getNetworkStats(const string& interface_name) {
+    for (const auto& stats : getAllNetworkStats()) {
+        if (stats.interface_name == interface_name) {
+            return stats;
+        }
+    }
+    
+    NetworkStats stats;
+    stats.interface_name = interface_name;
+    stats.rx_bytes = 0;
+    stats.rx_packets = 0;
+    stats.tx_bytes = 0;
+    stats.tx_packets = 0;
+    stats.rx_speed = 0.0f;
+    stats.tx_speed = 0.0f;
     return stats;
 }
 
-// Update network traffic graphs
-void updateNetworkGraph(NetworkGraph& rx_graph, NetworkGraph& tx_graph, const string& interface_name) {
-    static float lastUpdateTime = 0.0f;
-    static unsigned long last_rx_bytes = 0;
-    static unsigned long last_tx_bytes = 0;
+NetworkGraphRegistry::NetworkGraphRegistry()
+    : series((size_t)MAX_INTERFACES * 2 * Graph::MAX_VALUES, 0.0f), running(false), interval(1.0f / 30.0f) {
+    for (auto& slot : slots) {
+        slot.used = false;
+        slot.primed = false;
+        slot.last_rx_bytes = 0;
+        slot.last_tx_bytes = 0;
+        slot.values_offset = 0;
+    }
+}
+
+NetworkGraphRegistry::~NetworkGraphRegistry() {
+    stop();
+}
+
+// Start the background sampling thread
+void NetworkGraphRegistry::start() {
+    lock_guard<mutex> guard(lock);
+    if (running) return;
+    running = true;
+    worker = thread(&NetworkGraphRegistry::run, this);
+}
+
+// Stop the background sampling thread and wait for it to exit
+void NetworkGraphRegistry::stop() {
+    {
+        lock_guard<mutex> guard(lock);
+        if (!running) return;
+        running = false;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+// Set the sampling period (seconds between samples)
+void NetworkGraphRegistry::setInterval(float seconds) {
+    lock_guard<mutex> guard(lock);
+    interval = max(seconds, 1.0f / 60.0f);
+}
+
+int NetworkGraphRegistry::findSlot(const string& interface_name) const {
+    for (int i = 0; i < MAX_INTERFACES; i++) {
+        if (slots[i].used && slots[i].name == interface_name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int NetworkGraphRegistry::allocSlot(const string& interface_name) {
+    for (int i = 0; i < MAX_INTERFACES; i++) {
+        if (!slots[i].used) {
+            Slot& slot = slots[i];
+            slot.name = interface_name;
+            slot.used = true;
+            slot.primed = false;
+            slot.values_offset = 0;
+            fill(rxSeries(i), rxSeries(i) + Graph::MAX_VALUES, 0.0f);
+            fill(txSeries(i), txSeries(i) + Graph::MAX_VALUES, 0.0f);
+            return i;
+        }
+    }
+    return -1; // Registry full, interface gets no history
+}
+
+// Sample /proc/net/dev once and append the rates of every interface
+void NetworkGraphRegistry::sample() {
+    vector<NetworkStats> all_stats = getAllNetworkStats();
+    auto now = chrono::steady_clock::now();
     
-    float currentTime = ImGui::GetTime();
-    float deltaTime = currentTime - lastUpdateTime;
+    lock_guard<mutex> guard(lock);
+    bool seen[MAX_INTERFACES] = {false};
     
-    // Update at the specified FPS rate
-    if (deltaTime >= 1.0f / rx_graph.fps) {
-        NetworkStats stats = getNetworkStats(interface_name);
+    for (const auto& stats : all_stats) {
+        int index = findSlot(stats.interface_name);
+        if (index < 0) {
+            index = allocSlot(stats.interface_name);
+            if (index < 0) continue;
+        }
+        seen[index] = true;
         
-        // Calculate speeds (bytes per second)
-        if (last_rx_bytes > 0 && last_tx_bytes > 0 && deltaTime > 0) {
-            float rx_speed = (stats.rx_bytes - last_rx_bytes) / deltaTime;
-            float tx_speed = (stats.tx_bytes - last_tx_bytes) / deltaTime;
-            
-            // Add values to graphs (convert to KB/s for better visualization)
-            rx_graph.addValue(rx_speed / 1024.0f);
-            tx_graph.addValue(tx_speed / 1024.0f);
+        Slot& slot = slots[index];
+        float delta_time = chrono::duration<float>(now - slot.last_time).count();
+        
+        // Skip the first sample and counter resets (interface re-created)
+        if (slot.primed && delta_time > 0 &&
+            stats.rx_bytes >= slot.last_rx_bytes && stats.tx_bytes >= slot.last_tx_bytes) {
+            float rx_speed = (stats.rx_bytes - slot.last_rx_bytes) / delta_time;
+            float tx_speed = (stats.tx_bytes - slot.last_tx_bytes) / delta_time;
             
-            // Update stats object with calculated speeds
-            stats.rx_speed = rx_speed;
-            stats.tx_speed = tx_speed;
+            // Store as KB/s for better visualization
+            rxSeries(index)[slot.values_offset] = rx_speed / 1024.0f;
+            txSeries(index)[slot.values_offset] = tx_speed / 1024.0f;
+            slot.values_offset = (slot.values_offset + 1) % Graph::MAX_VALUES;
         }
         
-        // Store current values for next calculation
-        last_rx_bytes = stats.rx_bytes;
-        last_tx_bytes = stats.tx_bytes;
-        lastUpdateTime = currentTime;
+        slot.last_rx_bytes = stats.rx_bytes;
+        slot.last_tx_bytes = stats.tx_bytes;
+        slot.last_time = now;
+        slot.primed = true;
+    }
+    
+    // Release slots of interfaces that disappeared
+    for (int i = 0; i < MAX_INTERFACES; i++) {
+        if (slots[i].used && !seen[i]) {
+            slots[i].used = false;
+        }
+    }
+}
+
+void NetworkGraphRegistry::run() {
+    unique_lock<mutex> guard(lock);
+    while (running) {
+        guard.unlock();
+        sample();
+        guard.lock();
+        wake.wait_for(guard, chrono::duration<float>(interval), [this] { return !running; });
+    }
+}
+
+bool NetworkGraphRegistry::copyHistory(const string& interface_name, NetworkGraph& rx_graph, NetworkGraph& tx_graph) {
+    lock_guard<mutex> guard(lock);
+    int index = findSlot(interface_name);
+    if (index < 0) return false;
+    
+    memcpy(rx_graph.values, rxSeries(index), sizeof(rx_graph.values));
+    memcpy(tx_graph.values, txSeries(index), sizeof(tx_graph.values));
+    rx_graph.values_offset = slots[index].values_offset;
+    tx_graph.values_offset = slots[index].values_offset;
+    return true;
+}
+
+// Update network traffic graphs from the registry history of the selected interface
+void updateNetworkGraph(NetworkGraphRegistry& registry, NetworkGraph& rx_graph, NetworkGraph& tx_graph, const string& interface_name) {
+    // The registry samples at the graph FPS rate
+    registry.setInterval(1.0f / rx_graph.fps);
+    
+    // Paused graphs keep showing the frozen history
+    if (rx_graph.paused) return;
+    
+    if (!registry.copyHistory(interface_name, rx_graph, tx_graph)) {
+        memset(rx_graph.values, 0, sizeof(rx_graph.values));
+        memset(tx_graph.values, 0, sizeof(tx_graph.values));
+        rx_graph.values_offset = 0;
+        tx_graph.values_offset = 0;
     }
 }
 
@@ -298,12 +659,16 @@ vector<NetworkConnection> getActiveConnections() {
         
         while (getline(tcp_file, line)) {
             stringstream ss(line);
-            string sl, local_addr, rem_addr, st, tx_queue, rx_queue, tr, tm_when, retrnsmt, uid, timeout, inode;
+            // tx_queue:rx_queue and tr:tm->when are single colon-separated fields
+            string sl, local_addr, rem_addr, st, queues, timer, retrnsmt, uid, timeout, inode;
             
-            ss >> sl >> local_addr >> rem_addr >> st >> tx_queue >> rx_queue >> tr >> tm_when >> retrnsmt >> uid >> timeout >> inode;
+            ss >> sl >> local_addr >> rem_addr >> st >> queues >> timer >> retrnsmt >> uid >> timeout >> inode;
             
             NetworkConnection conn;
             conn.protocol = "TCP";
+            conn.remote_ip = 0;
+            conn.local_port = 0;
+            conn.remote_port = 0;
             
             // Parse local address (hex format: AAAAAAAA:PPPP)
             if (local_addr.length() >= 9) {
@@ -316,6 +681,7 @@ vector<NetworkConnection> getActiveConnections() {
                 inet_ntop(AF_INET, &in_addr, ip_str, INET_ADDRSTRLEN);
                 
                 conn.local_address = string(ip_str) + ":" + to_string(port);
+                conn.local_port = port;
             }
             
             // Parse remote address
@@ -329,24 +695,20 @@ vector<NetworkConnection> getActiveConnections() {
                 inet_ntop(AF_INET, &in_addr, ip_str, INET_ADDRSTRLEN);
                 
                 conn.remote_address = string(ip_str) + ":" + to_string(port);
+                conn.remote_ip = addr;
+                conn.remote_port = port;
             }
             
             // Parse state
-            int state_num = stoi(st, nullptr, 16);
-            switch (state_num) {
-                case 1: conn.state = "ESTABLISHED"; break;
-                case 2: conn.state = "SYN_SENT"; break;
-                case 3: conn.state = "SYN_RECV"; break;
-                case 4: conn.state = "FIN_WAIT1"; break;
-                case 5: conn.state = "FIN_WAIT2"; break;
-                case 6: conn.state = "TIME_WAIT"; break;
-                case 7: conn.state = "CLOSE"; break;
-                case 8: conn.state = "CLOSE_WAIT"; break;
-                case 9: conn.state = "LAST_ACK"; break;
-                case 10: conn.state = "LISTEN"; break;
-                case 11: conn.state = "CLOSING"; break;
-                default: conn.state = "UNKNOWN"; break;
-            }
+            conn.state_code = stoi(st, nullptr, 16);
+            conn.state = getTcpStateName(conn.state_code);
+            
+            // Queue depths (hex "tx:rx") and retransmit count
+            conn.tx_queue = 0;
+            conn.rx_queue = 0;
+            sscanf(queues.c_str(), "%x:%x", &conn.tx_queue, &conn.rx_queue);
+            conn.retransmits = stoul(retrnsmt, nullptr, 16);
+            conn.inode = stoul(inode);
             
             // Find process using the inode
             conn.pid = 0;
@@ -360,6 +722,398 @@ vector<NetworkConnection> getActiveConnections() {
     return connections;
 }
 
+// Map a kernel TCP state number to its name
+string getTcpStateName(int state) {
+    switch (state) {
+        case 1: return "ESTABLISHED";
+        case 2: return "SYN_SENT";
+        case 3: return "SYN_RECV";
+        case 4: return "FIN_WAIT1";
+        case 5: return "FIN_WAIT2";
+        case 6: return "TIME_WAIT";
+        case 7: return "CLOSE";
+        case 8: return "CLOSE_WAIT";
+        case 9: return "LAST_ACK";
+        case 10: return "LISTEN";
+        case 11: return "CLOSING";
+        default: return "UNKNOWN";
+    }
+}
+
+// Format a sock_diag socket address as "ip:port"
+static string formatDiagAddress(int family, const __be32* address, __be16 port) {
+    char ip_str[INET6_ADDRSTRLEN];
+    inet_ntop(family, address, ip_str, sizeof(ip_str));
+    if (family == AF_INET6) {
+        return "[" + string(ip_str) + "]:" + to_string(ntohs(port));
+    }
+    return string(ip_str) + ":" + to_string(ntohs(port));
+}
+
+// Dump the TCP sockets of one address family through sock_diag
+static void dumpTcpSockets(int family, vector<TcpConnectionMetrics>& metrics) {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (fd == -1) return;
+    
+    struct {
+        struct nlmsghdr header;
+        struct inet_diag_req_v2 body;
+    } request;
+    memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = sizeof(request);
+    request.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.body.sdiag_family = family;
+    request.body.sdiag_protocol = IPPROTO_TCP;
+    // Everything except LISTEN (10) and TIME_WAIT (6), which carry no tcp_info
+    request.body.idiag_states = 0xfff & ~((1 << 10) | (1 << 6));
+    request.body.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+    
+    if (send(fd, &request, sizeof(request), 0) == -1) {
+        close(fd);
+        return;
+    }
+    
+    alignas(struct nlmsghdr) char buffer[65536];
+    bool done = false;
+    while (!done) {
+        ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+        if (len <= 0) {
+            if (len == -1 && errno == EINTR) continue;
+            break;
+        }
+        
+        for (struct nlmsghdr* msg = (struct nlmsghdr*)buffer; NLMSG_OK(msg, (unsigned int)len); msg = NLMSG_NEXT(msg, len)) {
+            if (msg->nlmsg_type == NLMSG_DONE || msg->nlmsg_type == NLMSG_ERROR) {
+                done = true;
+                break;
+            }
+            if (msg->nlmsg_type != SOCK_DIAG_BY_FAMILY) continue;
+            
+            const struct inet_diag_msg* diag = (const struct inet_diag_msg*)NLMSG_DATA(msg);
+            TcpConnectionMetrics conn;
+            conn.local_address = formatDiagAddress(diag->idiag_family, diag->id.idiag_src, diag->id.idiag_sport);
+            conn.remote_address = formatDiagAddress(diag->idiag_family, diag->id.idiag_dst, diag->id.idiag_dport);
+            conn.state = getTcpStateName(diag->idiag_state);
+            conn.inode = diag->idiag_inode;
+            conn.uid = diag->idiag_uid;
+            conn.send_queue = diag->idiag_wqueue;
+            conn.recv_queue = diag->idiag_rqueue;
+            
+            // Older kernels send a shorter tcp_info, missing fields stay zero
+            struct tcp_info info;
+            memset(&info, 0, sizeof(info));
+            int attr_len = msg->nlmsg_len - NLMSG_LENGTH(sizeof(*diag));
+            for (struct rtattr* attr = (struct rtattr*)(diag + 1); RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+                if (attr->rta_type == INET_DIAG_INFO) {
+                    memcpy(&info, RTA_DATA(attr), min((size_t)RTA_PAYLOAD(attr), sizeof(info)));
+                }
+            }
+            
+            conn.srtt_ms = info.tcpi_rtt / 1000.0f;
+            conn.rttvar_ms = info.tcpi_rttvar / 1000.0f;
+            conn.snd_cwnd = info.tcpi_snd_cwnd;
+            conn.retransmits = info.tcpi_retransmits;
+            conn.total_retrans = info.tcpi_total_retrans;
+            conn.bytes_acked = info.tcpi_bytes_acked;
+            conn.bytes_received = info.tcpi_bytes_received;
+            conn.bytes_sent = info.tcpi_bytes_sent;
+            conn.delivery_rate = info.tcpi_delivery_rate;
+            metrics.push_back(conn);
+        }
+    }
+    
+    close(fd);
+}
+
+// Get tcp_info metrics for every IPv4 and IPv6 TCP connection
+vector<TcpConnectionMetrics> getTcpConnectionMetrics() {
+    vector<TcpConnectionMetrics> metrics;
+    dumpTcpSockets(AF_INET, metrics);
+    dumpTcpSockets(AF_INET6, metrics);
+    return metrics;
+}
+
+// Map socket inodes to the PID that owns them by scanning /proc/[pid]/fd
+unordered_map<unsigned long, int> getSocketInodeOwners() {
+    unordered_map<unsigned long, int> owners;
+    
+    DIR* proc_dir = opendir("/proc");
+    if (!proc_dir) return owners;
+    
+    struct dirent* entry;
+    char path[64];
+    char link[64];
+    while ((entry = readdir(proc_dir)) != nullptr) {
+        if (!isdigit(entry->d_name[0])) continue;
+        int pid = atoi(entry->d_name);
+        
+        snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+        DIR* fd_dir = opendir(path);
+        if (!fd_dir) continue; // Not ours to inspect
+        
+        int dir_fd = dirfd(fd_dir);
+        struct dirent* fd_entry;
+        while ((fd_entry = readdir(fd_dir)) != nullptr) {
+            if (!isdigit(fd_entry->d_name[0])) continue;
+            ssize_t len = readlinkat(dir_fd, fd_entry->d_name, link, sizeof(link) - 1);
+            if (len <= 0) continue;
+            link[len] = '\0';
+            
+            // Socket links look like "socket:[12345]"
+            unsigned long inode;
+            if (sscanf(link, "socket:[%lu]", &inode) == 1) {
+                owners.emplace(inode, pid);
+            }
+        }
+        closedir(fd_dir);
+    }
+    
+    closedir(proc_dir);
+    return owners;
+}
+
+ProcessNetworkAccounting::ProcessNetworkAccounting() : passes(0), primed(false), running(false), interval(2.0f) {}
+
+ProcessNetworkAccounting::~ProcessNetworkAccounting() {
+    stop();
+}
+
+// Start sampling on a background thread
+void ProcessNetworkAccounting::start() {
+    lock_guard<mutex> guard(lock);
+    if (running) return;
+    running = true;
+    worker = thread(&ProcessNetworkAccounting::run, this);
+}
+
+// Stop sampling and forget the per-socket state
+void ProcessNetworkAccounting::stop() {
+    {
+        lock_guard<mutex> guard(lock);
+        if (!running) return;
+        running = false;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    lru.clear();
+    lru_index.clear();
+    name_cache.clear();
+    primed = false;
+    talkers.clear();
+}
+
+void ProcessNetworkAccounting::setInterval(float seconds) {
+    lock_guard<mutex> guard(lock);
+    interval = max(seconds, 0.5f);
+}
+
+vector<ProcessTraffic> ProcessNetworkAccounting::topTalkers() const {
+    lock_guard<mutex> guard(lock);
+    return talkers;
+}
+
+void ProcessNetworkAccounting::sample() {
+    vector<TcpConnectionMetrics> sockets = getTcpConnectionMetrics();
+    unordered_map<unsigned long, int> owners = getSocketInodeOwners();
+    auto now = chrono::steady_clock::now();
+    float delta_time = chrono::duration<float>(now - last_time).count();
+    
+    map<int, ProcessTraffic> per_process;
+    passes++;
+    for (const auto& sock : sockets) {
+        if (sock.inode == 0) continue; // Orphaned socket
+        
+        unsigned long long sent_delta = 0, received_delta = 0;
+        auto it = lru_index.find(sock.inode);
+        if (it != lru_index.end()) {
+            SocketCounters& counters = *it->second;
+            if (sock.bytes_sent >= counters.bytes_sent) sent_delta = sock.bytes_sent - counters.bytes_sent;
+            if (sock.bytes_received >= counters.bytes_received) received_delta = sock.bytes_received - counters.bytes_received;
+            counters.seen = passes;
+            counters.bytes_sent = sock.bytes_sent;
+            counters.bytes_received = sock.bytes_received;
+            lru.splice(lru.begin(), lru, it->second); // Mark as most recently seen
+        } else {
+            // New since the last sample: everything it carried happened in this interval
+            if (primed) {
+                sent_delta = sock.bytes_sent;
+                received_delta = sock.bytes_received;
+            }
+            lru.push_front({sock.inode, passes, sock.bytes_sent, sock.bytes_received});
+            lru_index[sock.inode] = lru.begin();
+        }
+        
+        // Sockets we cannot attribute (other users, kernel) are grouped under PID 0
+        auto owner = owners.find(sock.inode);
+        int pid = owner != owners.end() ? owner->second : 0;
+        
+        ProcessTraffic& traffic = per_process[pid];
+        traffic.pid = pid;
+        traffic.sockets++;
+        traffic.tx_bytes += sent_delta;
+        traffic.rx_bytes += received_delta;
+    }
+    
+    // Everything listed this pass sits in front, so the back holds closed
+    // sockets; evicting a live one would count its lifetime as new traffic
+    // when it shows up again
+    while (lru.size() > MAX_TRACKED_SOCKETS && lru.back().seen != passes) {
+        lru_index.erase(lru.back().inode);
+        lru.pop_back();
+    }
+    
+    vector<ProcessTraffic> result;
+    map<pair<int, unsigned long long>, string> names;
+    for (auto& entry : per_process) {
+        ProcessTraffic& traffic = entry.second;
+        if (primed && delta_time > 0) {
+            traffic.tx_rate = traffic.tx_bytes / delta_time;
+            traffic.rx_rate = traffic.rx_bytes / delta_time;
+        }
+        
+        // Names are looked up once per process; the start time keeps a
+        // reused PID from inheriting the old name
+        pair<int, unsigned long long> key(traffic.pid, traffic.pid > 0 ? readProcessStartTime(traffic.pid) : 0);
+        auto name = name_cache.find(key);
+        if (name != name_cache.end()) {
+            traffic.process_name = move(name->second);
+        } else {
+            traffic.process_name = traffic.pid > 0 ? getProcessNameFromPid(traffic.pid) : "(unknown)";
+        }
+        names.emplace(key, traffic.process_name);
+        result.push_back(traffic);
+    }
+    
+    // Only processes that still own sockets keep their names
+    name_cache.swap(names);
+    
+    sort(result.begin(), result.end(), [](const ProcessTraffic& a, const ProcessTraffic& b) {
+        return a.tx_rate + a.rx_rate > b.tx_rate + b.rx_rate;
+    });
+    
+    primed = true;
+    last_time = now;
+    
+    lock_guard<mutex> guard(lock);
+    talkers.swap(result);
+}
+
+void ProcessNetworkAccounting::run() {
+    unique_lock<mutex> guard(lock);
+    while (running) {
+        guard.unlock();
+        sample();
+        guard.lock();
+        wake.wait_for(guard, chrono::duration<float>(interval), [this] { return !running; });
+    }
+}
+
+// Fill in the owning PID of each connection from its socket inode
+void assignConnectionOwners(vector<NetworkConnection>& connections) {
+    unordered_map<unsigned long, int> owners = getSocketInodeOwners();
+    for (auto& conn : connections) {
+        auto owner = owners.find(conn.inode);
+        conn.pid = owner != owners.end() ? owner->second : 0;
+    }
+}
+
+ConnectionAggregator::ConnectionAggregator() : current_stamp(0) {}
+
+// Build the grouping key of a connection (fits in 64 bits for every mode)
+uint64_t ConnectionAggregator::groupKey(const NetworkConnection& conn, ConnectionGroupBy group_by) {
+    switch (group_by) {
+        case GROUP_BY_REMOTE_IP: return conn.remote_ip;
+        case GROUP_BY_REMOTE_PORT: return conn.remote_port;
+        case GROUP_BY_LOCAL_PORT: return conn.local_port;
+        case GROUP_BY_STATE: return (uint64_t)conn.state_code;
+        case GROUP_BY_PROCESS: return (uint64_t)(uint32_t)conn.pid;
+    }
+    return 0;
+}
+
+// Human-readable label for a group key
+string ConnectionAggregator::groupLabel(uint64_t key, ConnectionGroupBy group_by) {
+    switch (group_by) {
+        case GROUP_BY_REMOTE_IP: {
+            char ip_str[INET_ADDRSTRLEN];
+            struct in_addr in_addr;
+            in_addr.s_addr = (uint32_t)key;
+            inet_ntop(AF_INET, &in_addr, ip_str, INET_ADDRSTRLEN);
+            return ip_str;
+        }
+        case GROUP_BY_REMOTE_PORT:
+        case GROUP_BY_LOCAL_PORT:
+            return to_string(key);
+        case GROUP_BY_STATE:
+            return getTcpStateName((int)key);
+        case GROUP_BY_PROCESS:
+            if (key == 0) return "(unknown)";
+            return getProcessNameFromPid((int)key) + " (" + to_string(key) + ")";
+    }
+    return "";
+}
+
+// Grow the table so it stays at most half full
+void ConnectionAggregator::reserve(size_t count) {
+    size_t wanted = 64;
+    while (wanted < count * 2) wanted <<= 1;
+    if (buckets.size() < wanted) {
+        buckets.assign(wanted, Bucket{0, 0, 0});
+        current_stamp = 0;
+    }
+}
+
+// Group connections by the chosen key, summing counts and queue depths
+void ConnectionAggregator::aggregate(const vector<NetworkConnection>& connections, ConnectionGroupBy group_by,
+                                     vector<ConnectionGroup>& groups) {
+    groups.clear();
+    reserve(connections.size());
+    
+    // A new stamp invalidates every bucket without touching memory
+    if (++current_stamp == 0) {
+        for (auto& bucket : buckets) bucket.stamp = 0;
+        current_stamp = 1;
+    }
+    
+    size_t mask = buckets.size() - 1;
+    for (const auto& conn : connections) {
+        uint64_t key = groupKey(conn, group_by);
+        
+        // splitmix64 finalizer spreads sequential ports and addresses
+        uint64_t hash = key + 0x9e3779b97f4a7c15ULL;
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+        hash ^= hash >> 31;
+        
+        // Linear probing
+        size_t index = hash & mask;
+        while (buckets[index].stamp == current_stamp && buckets[index].key != key) {
+            index = (index + 1) & mask;
+        }
+        
+        Bucket& bucket = buckets[index];
+        if (bucket.stamp != current_stamp) {
+            bucket.key = key;
+            bucket.stamp = current_stamp;
+            bucket.group = groups.size();
+            groups.push_back(ConnectionGroup{key, 0, 0, 0, string()});
+        }
+        
+        ConnectionGroup& group = groups[bucket.group];
+        group.count++;
+        group.tx_queue += conn.tx_queue;
+        group.rx_queue += conn.rx_queue;
+    }
+    
+    // Labels are only built once per group, not per row
+    for (auto& group : groups) {
+        group.label = groupLabel(group.key, group_by);
+    }
+}
+
 // Get listening ports
 vector<PortInfo> getListeningPorts() {
     vector<PortInfo> ports;
@@ -0,0 +1,270 @@
+#include "header.h"
+
+static const char* PROCESS_COLUMNS = "pid,ppid,uid,state,name,cpu_percent,memory_percent,rss_bytes,vsize_bytes,start_time";
+
+char* formatMetricValue(char* first, char* last, double value) {
+    const char* special = isnan(value) ? "NaN" : isinf(value) ? (value > 0 ? "+Inf" : "-Inf") : nullptr;
+    if (special) {
+        size_t len = min(strlen(special), (size_t)(last - first));
+        memcpy(first, special, len);
+        return first + len;
+    }
+    if (value == floor(value) && fabs(value) < 9007199254740992.0) {
+        return to_chars(first, last, (long long)value).ptr;
+    }
+    if (fabs(value) > FLT_MAX) return to_chars(first, last, value).ptr;
+    return to_chars(first, last, (float)value).ptr;
+}
+
+StreamWriter::StreamWriter()
+    : fd(-1), format(STREAM_NDJSON), rotate_bytes(0), keep_files(0), file_bytes(0), total_bytes(0),
+      buffer(new char[BUFFER_SIZE]), used(0), stamp_time(-1.0), stamp_len(0), csv_process_header(false) {}
+
+StreamWriter::~StreamWriter() {
+    close();
+}
+
+bool StreamWriter::open(const string& output_path, StreamFormat output_format, unsigned long long rotate_limit,
+                        int keep, string& error) {
+    lock_guard<mutex> guard(lock);
+    if (fd != -1) {
+        error = "already open";
+        return false;
+    }
+    if (output_path == "-") {
+        fd = dup(STDOUT_FILENO);
+        rotate_limit = 0;                 // Nothing to rotate
+    } else {
+        fd = ::open(output_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    }
+    if (fd == -1) {
+        error = output_path + ": " + strerror(errno);
+        return false;
+    }
+    
+    struct stat info;
+    path = output_path;
+    format = output_format;
+    rotate_bytes = rotate_limit;
+    keep_files = keep;
+    file_bytes = fstat(fd, &info) == 0 && S_ISREG(info.st_mode) ? info.st_size : 0;
+    used = 0;
+    csv_system_names.reset();
+    csv_process_header = false;
+    last_flush = chrono::steady_clock::now();
+    return true;
+}
+
+void StreamWriter::close() {
+    lock_guard<mutex> guard(lock);
+    if (fd == -1) return;
+    flush();
+    if (fd != -1) ::close(fd);
+    fd = -1;
+}
+
+void StreamWriter::flush() {
+    size_t done = 0;
+    while (done < used && fd != -1) {
+        ssize_t len = write(fd, buffer.get() + done, used - done);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            // Reader went away or the disk filled up; stop streaming
+            ::close(fd);
+            fd = -1;
+            break;
+        }
+        done += len;
+    }
+    file_bytes += done;
+    total_bytes += done;
+    used = 0;
+    last_flush = chrono::steady_clock::now();
+}
+
+// path -> path.1 -> ... -> path.keep_files, the oldest is dropped
+bool StreamWriter::rotate() {
+    ::close(fd);
+    for (int i = keep_files - 1; i >= 1; i--) {
+        rename((path + "." + to_string(i)).c_str(), (path + "." + to_string(i + 1)).c_str());
+    }
+    if (keep_files > 0) rename(path.c_str(), (path + ".1").c_str());
+    else unlink(path.c_str());
+    
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    file_bytes = 0;
+    csv_system_names.reset();
+    csv_process_header = false;
+    return fd != -1;
+}
+
+void StreamWriter::reserve(size_t bytes) {
+    if (used + bytes > BUFFER_SIZE) flush();
+}
+
+void StreamWriter::put(const char* text, size_t len) {
+    reserve(len);
+    memcpy(buffer.get() + used, text, len);
+    used += len;
+}
+
+void StreamWriter::putNumber(double value) {
+    reserve(32);
+    if (format == STREAM_NDJSON && !isfinite(value)) {
+        put("null", 4);   // JSON has no NaN or Inf
+        return;
+    }
+    used = formatMetricValue(buffer.get() + used, buffer.get() + BUFFER_SIZE, value) - buffer.get();
+}
+
+// JSON string, or a CSV field quoted only when it has to be
+void StreamWriter::putText(const char* text, size_t len) {
+    reserve(len * 6 + 2);
+    if (format == STREAM_NDJSON) {
+        static const char HEX[] = "0123456789abcdef";
+        size_t plain = 0;
+        while (plain < len && (unsigned char)text[plain] >= 0x20 && text[plain] != '"' && text[plain] != '\\') plain++;
+        put('"');
+        if (plain == len) {
+            put(text, len);
+            put('"');
+            return;
+        }
+        for (size_t i = 0; i < len; i++) {
+            unsigned char c = text[i];
+            if (c == '"' || c == '\\') {
+                put('\\');
+                put(c);
+            } else if (c < 0x20) {
+                put("\\u00", 4);
+                put(HEX[c >> 4]);
+                put(HEX[c & 15]);
+            } else {
+                put(c);
+            }
+        }
+        put('"');
+        return;
+    }
+    
+    bool quote = false;
+    for (size_t i = 0; i < len && !quote; i++) {
+        quote = text[i] == ',' || text[i] == '"' || text[i] == '\n' || text[i] == '\r';
+    }
+    if (!quote) {
+        put(text, len);
+        return;
+    }
+    put('"');
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '"') put('"');
+        put(text[i]);
+    }
+    put('"');
+}
+
+void StreamWriter::beginRecord(const char* kind, double time) {
+    if (time != stamp_time) {
+        stamp_len = to_chars(stamp, stamp + sizeof(stamp), time, chars_format::fixed, 3).ptr - stamp;
+        stamp_time = time;
+    }
+    reserve(MAX_FIELD);
+    if (format == STREAM_NDJSON) {
+        put("{\"kind\":\"", 9);
+        put(kind, strlen(kind));
+        put("\",\"time\":", 9);
+    } else {
+        put(kind, strlen(kind));
+        put(',');
+    }
+    put(stamp, stamp_len);
+}
+
+void StreamWriter::key(const char* name) {
+    reserve(MAX_FIELD);
+    put(',');
+    if (format == STREAM_NDJSON) {
+        putText(name, strlen(name));
+        put(':');
+    }
+}
+
+void StreamWriter::endRecord() {
+    reserve(2);
+    if (format == STREAM_NDJSON) put('}');
+    put('\n');
+}
+
+// Records never straddle a rotation; data is pushed out at least once a
+// second even when the buffer is far from full
+void StreamWriter::finishRecords() {
+    if (rotate_bytes > 0 && file_bytes + used >= rotate_bytes) {
+        flush();
+        if (fd != -1) rotate();
+    } else if (chrono::steady_clock::now() - last_flush >= chrono::seconds(1)) {
+        flush();
+    }
+}
+
+void StreamWriter::writeSystem(const SystemSample& sample) {
+    lock_guard<mutex> guard(lock);
+    if (fd == -1 || !sample.names) return;
+    const vector<string>& names = *sample.names;
+    
+    if (format == STREAM_CSV && csv_system_names != sample.names) {
+        put("#system,time", 12);
+        for (const auto& name : names) {
+            put(',');
+            putText(name.data(), name.size());
+        }
+        put('\n');
+        csv_system_names = sample.names;
+    }
+    
+    beginRecord("system", sample.wall_time);
+    for (size_t i = 0; i < names.size(); i++) {
+        key(names[i].c_str());
+        putNumber(sample.values[i]);
+    }
+    endRecord();
+    finishRecords();
+}
+
+void StreamWriter::writeProcesses(const ProcessSnapshot& snapshot) {
+    lock_guard<mutex> guard(lock);
+    if (fd == -1) return;
+    double time = chrono::duration<double>(chrono::system_clock::now().time_since_epoch()).count();
+    
+    if (format == STREAM_CSV && !csv_process_header) {
+        put("#process,time,", 14);
+        put(PROCESS_COLUMNS, strlen(PROCESS_COLUMNS));
+        put('\n');
+        csv_process_header = true;
+    }
+    
+    for (const auto& proc : snapshot.processes) {
+        beginRecord("process", time);
+        key("pid");
+        putNumber(proc.pid);
+        key("ppid");
+        putNumber(proc.ppid);
+        key("uid");
+        putNumber(proc.uid == (uid_t)-1 ? NAN : (double)proc.uid);
+        key("state");
+        putText(&proc.state, 1);
+        key("name");
+        putText(proc.name.data(), proc.name.size());
+        key("cpu_percent");
+        putNumber(proc.cpu_usage);
+        key("memory_percent");
+        putNumber(proc.memory_usage);
+        key("rss_bytes");
+        putNumber(proc.rss);
+        key("vsize_bytes");
+        putNumber(proc.vsize);
+        key("start_time");
+        putNumber(proc.start_time);
+        endRecord();
+    }
+    finishRecords();
+}
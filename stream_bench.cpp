@@ -0,0 +1,101 @@
+#include "header.h"
+
+// Streams synthetic samples (a 90-series system sample plus a full process
+// table) through StreamWriter and reports samples/sec for each format and
+// table size. Heap allocations are counted by replacing operator new, so
+// the steady-state per-sample count can be checked. Built by "make bench".
+
+static atomic<unsigned long> g_allocations(0);
+
+void* operator new(size_t size) {
+    g_allocations++;
+    void* memory = malloc(size ? size : 1);
+    if (!memory) throw bad_alloc();
+    return memory;
+}
+
+void* operator new[](size_t size) {
+    g_allocations++;
+    void* memory = malloc(size ? size : 1);
+    if (!memory) throw bad_alloc();
+    return memory;
+}
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+
+static ProcessSnapshot makeSnapshot(int count) {
+    ProcessSnapshot snapshot;
+    snapshot.generation = 1;
+    for (int i = 0; i < count; i++) {
+        Process proc;
+        proc.pid = 1000 + i;
+        proc.ppid = 1;
+        proc.uid = 1000;
+        proc.state = 'S';
+        proc.name = i % 97 == 0 ? "needs \"quoting\", too" : "worker-" + to_string(i % 50);
+        proc.cpu_usage = (i % 100) * 0.37f;
+        proc.memory_usage = (i % 13) * 0.11f;
+        proc.rss = 1234567LL * (i % 7 + 1);
+        proc.vsize = 987654321LL + i;
+        proc.start_time = 123456 + i;
+        snapshot.processes.push_back(proc);
+    }
+    return snapshot;
+}
+
+static SystemSample makeSystemSample() {
+    SystemSample sample;
+    sample.generation = 1;
+    sample.time = 1.0;
+    sample.wall_time = 1760800000.125;
+    auto names = make_shared<vector<string>>();
+    for (int i = 0; i < 90; i++) {
+        names->push_back("series." + to_string(i) + ".value");
+        sample.values.push_back(i * 1.37);
+    }
+    sample.names = names;
+    return sample;
+}
+
+int main(int argc, char** argv) {
+    const char* output = argc > 1 ? argv[1] : "/dev/null";
+    SystemSample system = makeSystemSample();
+    
+    printf("output %s\n", output);
+    for (int count : {1000, 10000}) {
+        ProcessSnapshot snapshot = makeSnapshot(count);
+        int rounds = count == 1000 ? 2000 : 200;
+        for (StreamFormat format : {STREAM_NDJSON, STREAM_CSV}) {
+            StreamWriter writer;
+            string error;
+            if (!writer.open(output, format, 0, 0, error)) {
+                fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+            // Warm up: headers and first-use allocations are not per sample
+            writer.writeSystem(system);
+            writer.writeProcesses(snapshot);
+            unsigned long long bytes_before = writer.bytesWritten();
+            
+            unsigned long allocations_before = g_allocations;
+            auto start = chrono::steady_clock::now();
+            for (int round = 0; round < rounds; round++) {
+                system.wall_time += 1.0;
+                writer.writeSystem(system);
+                writer.writeProcesses(snapshot);
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            unsigned long allocations = g_allocations - allocations_before;
+            unsigned long long bytes = writer.bytesWritten() - bytes_before;
+            writer.close();
+            
+            printf("  %5d processes  %-6s  %8.0f samples/s  %7.1f MB/s  %5.2f M rows/s  %.2f allocations/sample\n",
+                   count, format == STREAM_CSV ? "csv" : "ndjson", rounds / seconds, bytes / seconds / 1e6,
+                   rounds * (count + 1.0) / seconds / 1e6, (double)allocations / rounds);
+        }
+    }
+    return 0;
+}
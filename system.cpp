@@ -51,6 +51,513 @@ vector<float> getLoadAverage() {
     return loads;
 }
 
+static const char* PSI_PATHS[PSI_RESOURCE_COUNT] = {
+    "/proc/pressure/cpu",
+    "/proc/pressure/memory",
+    "/proc/pressure/io",
+};
+
+const char* getPsiResourceName(PsiResource resource) {
+    switch (resource) {
+        case PSI_CPU: return "CPU";
+        case PSI_MEMORY: return "Memory";
+        case PSI_IO: return "IO";
+        default: return "?";
+    }
+}
+
+// Parse the "some ..." and "full ..." lines of a pressure file
+bool parsePsiText(const char* text, size_t len, PsiStats& stats) {
+    memset(&stats, 0, sizeof(stats));
+    bool has_some = false;
+    const char* p = text;
+    const char* end = text + len;
+    while (p < end) {
+        const char* line_end = (const char*)memchr(p, '\n', end - p);
+        if (!line_end) line_end = end;
+        
+        char line[128];
+        size_t line_len = min((size_t)(line_end - p), sizeof(line) - 1);
+        memcpy(line, p, line_len);
+        line[line_len] = '\0';
+        
+        PsiLine parsed;
+        char kind[8];
+        if (sscanf(line, "%7s avg10=%f avg60=%f avg300=%f total=%llu",
+                   kind, &parsed.avg10, &parsed.avg60, &parsed.avg300, &parsed.total) == 5) {
+            if (strcmp(kind, "some") == 0) {
+                stats.some = parsed;
+                has_some = true;
+            } else if (strcmp(kind, "full") == 0) {
+                stats.full = parsed;
+                stats.has_full = true;
+            }
+        }
+        p = line_end + 1;
+    }
+    return has_some;
+}
+
+PressureMonitor::PressureMonitor() : primed(false), wake_fd(-1), triggered(false), triggers_running(false) {
+    memset(stats, 0, sizeof(stats));
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        fds[i] = open(PSI_PATHS[i], O_RDONLY | O_CLOEXEC);
+        trigger_fds[i] = -1;
+        some_percent[i] = 0.0f;
+        full_percent[i] = 0.0f;
+        trigger_counts[i] = 0;
+        last_trigger_ns[i] = 0;
+    }
+}
+
+PressureMonitor::~PressureMonitor() {
+    disableTriggers();
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+}
+
+// Re-read all pressure files and derive the stall share of the interval
+// since the previous sample from the microsecond `total` counters, which is
+// exact where the kernel's avg10 is an exponentially decayed average.
+void PressureMonitor::sample() {
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    double elapsed_us = chrono::duration<double, micro>(now - last_time).count();
+    
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (fds[i] < 0) continue;
+        
+        char buffer[256];
+        ssize_t len = pread(fds[i], buffer, sizeof(buffer), 0);
+        PsiStats current;
+        if (len <= 0 || !parsePsiText(buffer, len, current)) continue;
+        
+        if (primed && elapsed_us > 0) {
+            unsigned long long some_delta = current.some.total - stats[i].some.total;
+            unsigned long long full_delta = current.full.total - stats[i].full.total;
+            some_percent[i] = min(100.0f, (float)(some_delta * 100.0 / elapsed_us));
+            full_percent[i] = current.has_full ? min(100.0f, (float)(full_delta * 100.0 / elapsed_us)) : 0.0f;
+            some_history[i].addValue(some_percent[i]);
+            full_history[i].addValue(full_percent[i]);
+        }
+        stats[i] = current;
+    }
+    
+    primed = true;
+    last_time = now;
+}
+
+// Arm a "some" trigger on every pressure file and start the poll thread.
+// Unprivileged users may only use windows that are multiples of 2s.
+bool PressureMonitor::enableTriggers(unsigned int threshold_us, unsigned int window_us, string& error) {
+    disableTriggers();
+    
+    char request[64];
+    snprintf(request, sizeof(request), "some %u %u", threshold_us, window_us);
+    
+    int armed = 0;
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (fds[i] < 0) continue;
+        int fd = open(PSI_PATHS[i], O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd == -1) {
+            error = string(PSI_PATHS[i]) + ": " + strerror(errno);
+            continue;
+        }
+        // The kernel expects the terminating NUL to be written as well
+        if (write(fd, request, strlen(request) + 1) < 0) {
+            error = string(PSI_PATHS[i]) + ": " + strerror(errno);
+            close(fd);
+            continue;
+        }
+        trigger_fds[i] = fd;
+        armed++;
+    }
+    if (armed == 0) {
+        if (error.empty()) error = "PSI is not available";
+        return false;
+    }
+    
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd == -1) {
+        error = string("eventfd: ") + strerror(errno);
+        disableTriggers();
+        return false;
+    }
+    
+    triggers_running = true;
+    trigger_worker = thread(&PressureMonitor::runTriggers, this);
+    return true;
+}
+
+void PressureMonitor::disableTriggers() {
+    if (triggers_running) {
+        triggers_running = false;
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0) {
+            // Thread still exits on its next wakeup
+        }
+    }
+    if (trigger_worker.joinable()) {
+        trigger_worker.join();
+    }
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (trigger_fds[i] >= 0) {
+            close(trigger_fds[i]);   // Closing the fd removes the trigger
+            trigger_fds[i] = -1;
+        }
+    }
+    if (wake_fd >= 0) {
+        close(wake_fd);
+        wake_fd = -1;
+    }
+}
+
+float PressureMonitor::secondsSinceTrigger(PsiResource resource) const {
+    long long fired = last_trigger_ns[resource].load();
+    if (fired == 0) return -1.0f;
+    long long now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    return (now - fired) / 1e9f;
+}
+
+// Block until a trigger fires (POLLPRI) or stop is requested through wake_fd
+void PressureMonitor::runTriggers() {
+    struct pollfd pfds[PSI_RESOURCE_COUNT + 1];
+    int resources[PSI_RESOURCE_COUNT];
+    int count = 0;
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (trigger_fds[i] < 0) continue;
+        pfds[count].fd = trigger_fds[i];
+        pfds[count].events = POLLPRI;
+        resources[count] = i;
+        count++;
+    }
+    pfds[count].fd = wake_fd;
+    pfds[count].events = POLLIN;
+    
+    while (triggers_running) {
+        int ready = poll(pfds, count + 1, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (pfds[count].revents & POLLIN) break;
+        
+        long long now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+        for (int i = 0; i < count; i++) {
+            if (pfds[i].revents & POLLERR) {
+                pfds[i].fd = -1;   // Monitor went away, stop polling it
+            } else if (pfds[i].revents & POLLPRI) {
+                trigger_counts[resources[i]]++;
+                last_trigger_ns[resources[i]] = now;
+                triggered = true;
+            }
+        }
+    }
+    triggers_running = false;
+}
+
+// Value of a "key value" line in a flat-keyed cgroup file, 0 if missing
+static unsigned long long cgroupStatValue(const char* text, size_t len, const char* key) {
+    size_t key_len = strlen(key);
+    const char* p = text;
+    const char* end = text + len;
+    while (p < end) {
+        const char* line_end = (const char*)memchr(p, '\n', end - p);
+        if (!line_end) line_end = end;
+        if ((size_t)(line_end - p) > key_len && memcmp(p, key, key_len) == 0 && p[key_len] == ' ') {
+            return strtoull(p + key_len + 1, nullptr, 10);
+        }
+        p = line_end + 1;
+    }
+    return 0;
+}
+
+CgroupCollector::CgroupCollector() : dirty(false), read_buffer(8192) {
+    // Every group holds a directory fd; large hierarchies need more than
+    // the default soft limit
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    open();
+}
+
+CgroupCollector::~CgroupCollector() {
+    for (auto& node : nodes) {
+        if (node.dir_fd >= 0) close(node.dir_fd);
+    }
+}
+
+// Locate the cgroup2 mount (pure v2 at /sys/fs/cgroup, or the "unified"
+// mount on hybrid systems) and build the initial tree
+bool CgroupCollector::open() {
+    ifstream mountinfo("/proc/self/mountinfo");
+    string line;
+    while (getline(mountinfo, line)) {
+        size_t separator = line.find(" - ");
+        if (separator == string::npos) continue;
+        if (line.compare(separator + 3, 8, "cgroup2 ") != 0) continue;
+        
+        istringstream fields(line);
+        string id, parent_id, device, root, mount_point;
+        fields >> id >> parent_id >> device >> root >> mount_point;
+        if (root_path.empty() || mount_point == "/sys/fs/cgroup") {
+            root_path = mount_point;
+        }
+    }
+    if (root_path.empty()) return false;
+    
+    int fd = ::open(root_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) return false;
+    addNode(-1, "", fd);
+    scanChildren(0);
+    last_time = chrono::steady_clock::now();
+    last_full_scan = last_time;
+    return true;
+}
+
+int CgroupCollector::addNode(int parent, const string& name, int dir_fd) {
+    CgroupNode node;
+    memset(node.pressure, 0, sizeof(node.pressure));
+    node.name = name;
+    node.path = parent < 0 ? "/" : (nodes[parent].path == "/" ? "/" + name : nodes[parent].path + "/" + name);
+    node.parent = parent;
+    node.depth = parent < 0 ? 0 : nodes[parent].depth + 1;
+    node.dir_fd = dir_fd;
+    node.links = 0;
+    node.cpu_usage_usec = node.cpu_user_usec = node.cpu_system_usec = 0;
+    node.nr_throttled = node.throttled_usec = 0;
+    node.memory_current = node.memory_anon = node.memory_file = node.memory_kernel = 0;
+    node.io_rbytes = node.io_wbytes = node.io_rios = node.io_wios = 0;
+    node.cpu_percent = node.io_read_rate = node.io_write_rate = 0.0f;
+    node.primed = false;
+    
+    nodes.push_back(node);
+    int index = (int)nodes.size() - 1;
+    if (parent >= 0) nodes[parent].children.push_back(index);
+    return index;
+}
+
+// Reconcile the children of one group with its directory listing. New
+// groups are opened and scanned recursively, vanished ones are dropped.
+void CgroupCollector::scanChildren(int index) {
+    struct stat st;
+    if (fstat(nodes[index].dir_fd, &st) == 0) {
+        nodes[index].links = st.st_nlink;
+    }
+    
+    int list_fd = dup(nodes[index].dir_fd);
+    if (list_fd == -1) return;
+    DIR* dir = fdopendir(list_fd);
+    if (!dir) {
+        close(list_fd);
+        return;
+    }
+    rewinddir(dir);
+    
+    set<string> present;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_type != DT_DIR || entry->d_name[0] == '.') continue;
+        present.insert(entry->d_name);
+    }
+    closedir(dir);
+    
+    // Drop children that are gone
+    vector<int> children = nodes[index].children;
+    for (int child : children) {
+        if (present.erase(nodes[child].name) == 0) {
+            removeSubtree(child);
+        }
+    }
+    
+    // Whatever is left is new
+    for (const string& name : present) {
+        int fd = openat(nodes[index].dir_fd, name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd == -1) continue;
+        int child = addNode(index, name, fd);
+        scanChildren(child);
+    }
+}
+
+// Close a group and its descendants; indices are compacted after the sample
+void CgroupCollector::removeSubtree(int index) {
+    CgroupNode& node = nodes[index];
+    if (node.dir_fd < 0) return;
+    close(node.dir_fd);
+    node.dir_fd = -1;
+    for (int child : node.children) {
+        removeSubtree(child);
+    }
+    node.children.clear();
+    if (node.parent >= 0) {
+        vector<int>& siblings = nodes[node.parent].children;
+        siblings.erase(remove(siblings.begin(), siblings.end(), index), siblings.end());
+    }
+    dirty = true;
+}
+
+// Squeeze out removed groups and renumber parent/child links
+void CgroupCollector::compact() {
+    vector<int> remap(nodes.size(), -1);
+    int next = 0;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].dir_fd >= 0) remap[i] = next++;
+    }
+    vector<CgroupNode> kept;
+    kept.reserve(next);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (remap[i] < 0) continue;
+        CgroupNode& node = nodes[i];
+        node.parent = node.parent >= 0 ? remap[node.parent] : -1;
+        for (int& child : node.children) child = remap[child];
+        kept.push_back(std::move(node));
+    }
+    nodes.swap(kept);
+    dirty = false;
+}
+
+ssize_t CgroupCollector::readFile(int dir_fd, const char* name) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return -1;
+    ssize_t len = read(fd, read_buffer.data(), read_buffer.size());
+    close(fd);
+    return len;
+}
+
+// Read one group's stat files. Returns false if the group has been removed.
+bool CgroupCollector::readNode(CgroupNode& node, double elapsed_sec) {
+    // cpu.stat exists in every cgroup2 group, failing to open it means the
+    // directory is gone
+    ssize_t len = readFile(node.dir_fd, "cpu.stat");
+    if (len < 0) return !(errno == ENOENT || errno == ENODEV);
+    
+    unsigned long long usage = cgroupStatValue(read_buffer.data(), len, "usage_usec");
+    node.cpu_user_usec = cgroupStatValue(read_buffer.data(), len, "user_usec");
+    node.cpu_system_usec = cgroupStatValue(read_buffer.data(), len, "system_usec");
+    node.nr_throttled = cgroupStatValue(read_buffer.data(), len, "nr_throttled");
+    node.throttled_usec = cgroupStatValue(read_buffer.data(), len, "throttled_usec");
+    
+    // Memory controller files are absent on the root and where disabled
+    len = readFile(node.dir_fd, "memory.current");
+    node.memory_current = len > 0 ? strtoull(read_buffer.data(), nullptr, 10) : 0;
+    len = readFile(node.dir_fd, "memory.stat");
+    if (len > 0) {
+        node.memory_anon = cgroupStatValue(read_buffer.data(), len, "anon");
+        node.memory_file = cgroupStatValue(read_buffer.data(), len, "file");
+        node.memory_kernel = cgroupStatValue(read_buffer.data(), len, "kernel");
+    }
+    
+    // io.stat has one line per device: "8:0 rbytes=.. wbytes=.. rios=.. wios=.."
+    unsigned long long rbytes = 0, wbytes = 0, rios = 0, wios = 0;
+    len = readFile(node.dir_fd, "io.stat");
+    if (len > 0) {
+        const char* p = read_buffer.data();
+        const char* end = p + len;
+        while (p < end) {
+            const char* line_end = (const char*)memchr(p, '\n', end - p);
+            if (!line_end) line_end = end;
+            for (const char* field = p; field < line_end; field++) {
+                if (*field != ' ') continue;
+                if (strncmp(field + 1, "rbytes=", 7) == 0) rbytes += strtoull(field + 8, nullptr, 10);
+                else if (strncmp(field + 1, "wbytes=", 7) == 0) wbytes += strtoull(field + 8, nullptr, 10);
+                else if (strncmp(field + 1, "rios=", 5) == 0) rios += strtoull(field + 6, nullptr, 10);
+                else if (strncmp(field + 1, "wios=", 5) == 0) wios += strtoull(field + 6, nullptr, 10);
+            }
+            p = line_end + 1;
+        }
+    }
+    
+    static const char* PRESSURE_FILES[PSI_RESOURCE_COUNT] = {"cpu.pressure", "memory.pressure", "io.pressure"};
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        PsiStats stats;
+        len = readFile(node.dir_fd, PRESSURE_FILES[i]);
+        node.pressure[i] = (len > 0 && parsePsiText(read_buffer.data(), len, stats)) ? stats.some.avg10 : 0.0f;
+    }
+    
+    if (node.primed && elapsed_sec > 0) {
+        node.cpu_percent = (float)((usage - node.cpu_usage_usec) / (elapsed_sec * 1e6) * 100.0);
+        node.io_read_rate = (float)((rbytes - node.io_rbytes) / elapsed_sec);
+        node.io_write_rate = (float)((wbytes - node.io_wbytes) / elapsed_sec);
+    }
+    node.cpu_usage_usec = usage;
+    node.io_rbytes = rbytes;
+    node.io_wbytes = wbytes;
+    node.io_rios = rios;
+    node.io_wios = wios;
+    node.primed = true;
+    return true;
+}
+
+// Sample every group. Only directories whose link count changed are
+// re-listed, except on the periodic full reconciliation.
+void CgroupCollector::sample() {
+    if (nodes.empty()) return;
+    
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    double elapsed = chrono::duration<double>(now - last_time).count();
+    bool full_scan = chrono::duration<float>(now - last_full_scan).count() >= RESCAN_INTERVAL;
+    if (full_scan) last_full_scan = now;
+    
+    // New groups are appended while iterating and get read in the same pass
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].dir_fd < 0) continue;
+        
+        struct stat st;
+        if (fstat(nodes[i].dir_fd, &st) == 0 && (full_scan || st.st_nlink != nodes[i].links)) {
+            scanChildren((int)i);
+        }
+        if (!readNode(nodes[i], elapsed) && i > 0) {
+            // A group vanished, its parent may have gained a replacement
+            // without its link count changing
+            int parent = nodes[i].parent;
+            removeSubtree((int)i);
+            scanChildren(parent);
+        }
+    }
+    
+    if (dirty) compact();
+    last_time = now;
+}
+
+void CgroupCollector::sortedOrder(CgroupSortColumn column, bool ascending, vector<int>& out) const {
+    out.clear();
+    if (nodes.empty()) return;
+    
+    auto key_less = [this, column](int a, int b) {
+        const CgroupNode& x = nodes[a];
+        const CgroupNode& y = nodes[b];
+        switch (column) {
+            case CGROUP_SORT_NAME: return x.name < y.name;
+            case CGROUP_SORT_CPU: return x.cpu_percent < y.cpu_percent;
+            case CGROUP_SORT_MEMORY: return x.memory_current < y.memory_current;
+            case CGROUP_SORT_IO_READ: return x.io_read_rate < y.io_read_rate;
+            case CGROUP_SORT_IO_WRITE: return x.io_write_rate < y.io_write_rate;
+            case CGROUP_SORT_CPU_PRESSURE: return x.pressure[PSI_CPU] < y.pressure[PSI_CPU];
+            case CGROUP_SORT_MEMORY_PRESSURE: return x.pressure[PSI_MEMORY] < y.pressure[PSI_MEMORY];
+            case CGROUP_SORT_IO_PRESSURE: return x.pressure[PSI_IO] < y.pressure[PSI_IO];
+            default: return false;
+        }
+    };
+    
+    // Iterative depth-first walk; children are pushed in reverse so the
+    // first in sort order is emitted first
+    vector<int> stack(1, 0);
+    vector<int> children;
+    while (!stack.empty()) {
+        int index = stack.back();
+        stack.pop_back();
+        out.push_back(index);
+        
+        children = nodes[index].children;
+        sort(children.begin(), children.end(), [&](int a, int b) {
+            return ascending ? key_less(a, b) : key_less(b, a);
+        });
+        stack.insert(stack.end(), children.rbegin(), children.rend());
+    }
+}
+
 // Track CPU usage history for graph
 void updateCPUGraph(CPUGraph& graph) {
     static float lastUpdateTime = 0.0f;
@@ -351,6 +858,27 @@ map<string, int> getProcessCounts() {
     return counts;
 }
 
+// Count process states from an already sampled table
+map<string, int> getProcessCounts(const vector<Process>& processes) {
+    map<string, int> counts;
+    counts["running"] = 0;
+    counts["sleeping"] = 0;
+    counts["stopped"] = 0;
+    counts["zombie"] = 0;
+    
+    for (const auto& proc : processes) {
+        switch (proc.state) {
+            case 'R': counts["running"]++; break;
+            case 'T':
+            case 't': counts["stopped"]++; break;
+            case 'Z': counts["zombie"]++; break;
+            case 'X': break;
+            default: counts["sleeping"]++; break;   // S, I, D and unknown states
+        }
+    }
+    return counts;
+}
+
 // get cpu id and information, you can use `proc/cpuinfo`
 string CPUinfo()
 {
@@ -400,3 +928,214 @@ const char *getOsName()
     return "Other";
 #endif
 }
+
+SystemSampler::SystemSampler()
+    : samples(0), primed(false), pending_count(0), names(make_shared<vector<string>>()), generation(0),
+      published(make_shared<SystemSample>()), running(false), interval(1.0f) {
+    memset(&meminfo, 0, sizeof(meminfo));
+}
+
+SystemSampler::~SystemSampler() {
+    stop();
+}
+
+void SystemSampler::start(float seconds) {
+    lock_guard<mutex> guard(lock);
+    if (running) return;
+    running = true;
+    interval = seconds;
+    worker = thread(&SystemSampler::run, this);
+}
+
+void SystemSampler::stop() {
+    {
+        lock_guard<mutex> guard(lock);
+        if (!running) return;
+        running = false;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void SystemSampler::addSampleHook(function<void(const SystemSample&)> hook) {
+    hooks.push_back(hook);
+}
+
+shared_ptr<const SystemSample> SystemSampler::latest() const {
+    lock_guard<mutex> guard(lock);
+    return published;
+}
+
+void SystemSampler::run() {
+    unique_lock<mutex> guard(lock);
+    while (running) {
+        guard.unlock();
+        sample();
+        guard.lock();
+        
+        auto next = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float>(interval));
+        wake.wait_until(guard, next, [this] { return !running; });
+    }
+}
+
+void SystemSampler::add(const char* name, double value) {
+    if (pending_count == pending_names.size()) {
+        pending_names.emplace_back();
+        pending_values.push_back(0.0);
+    }
+    pending_names[pending_count].assign(name);
+    pending_values[pending_count] = value;
+    pending_count++;
+}
+
+void SystemSampler::add(const char* group, const string& instance, const char* field, double value) {
+    if (pending_count == pending_names.size()) {
+        pending_names.emplace_back();
+        pending_values.push_back(0.0);
+    }
+    string& name = pending_names[pending_count];
+    name.assign(group);
+    name += '.';
+    name += instance;
+    name += '.';
+    name += field;
+    pending_values[pending_count] = value;
+    pending_count++;
+}
+
+// Busy share of every "cpu" line of /proc/stat since the last sample
+void SystemSampler::sampleCpu() {
+    if (!readFileInto("/proc/stat", read_buffer)) return;
+    
+    size_t line_index = 0;
+    const char* line = read_buffer.data();
+    while (strncmp(line, "cpu", 3) == 0) {
+        unsigned long long user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+        const char* fields = line + 3;
+        while (*fields && *fields != ' ') fields++;
+        sscanf(fields, "%llu %llu %llu %llu %llu %llu %llu %llu",
+               &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
+        CpuTimes now = {user + nice + system + irq + softirq + steal, 0};
+        now.total = now.busy + idle + iowait;
+        
+        if (line_index == cpu_times.size()) cpu_times.push_back({0, 0});
+        CpuTimes& previous = cpu_times[line_index];
+        unsigned long long total_delta = now.total - previous.total;
+        double usage = primed && now.total > previous.total
+            ? (double)(now.busy - previous.busy) * 100.0 / total_delta : 0.0;
+        previous = now;
+        
+        if (primed) {
+            if (line_index == 0) add("cpu.usage", usage);
+            else add("cpu", to_string(line_index - 1), "usage", usage);
+        }
+        line_index++;
+        
+        const char* next = strchr(line, '\n');
+        if (!next) break;
+        line = next + 1;
+    }
+    cpu_times.resize(line_index);
+}
+
+// Rates need two samples, so the first call only primes the counters
+void SystemSampler::sample() {
+    auto now = chrono::steady_clock::now();
+    double elapsed = chrono::duration<double>(now - last_time).count();
+    pending_count = 0;
+    
+    sampleCpu();
+    
+    vector<float> loads = getLoadAverage();
+    add("load.1", loads[0]);
+    add("load.5", loads[1]);
+    add("load.15", loads[2]);
+    add("thermal.cpu", getCPUTemperature());
+    add("fan.speed", getFanSpeed());
+    
+    if (parseMemInfo(meminfo) && meminfo.mem_total > 0) {
+        add("memory.used_percent", (double)(meminfo.mem_total - meminfo.mem_available) * 100.0 / meminfo.mem_total);
+        add("memory.total_bytes", (double)meminfo.mem_total * 1024.0);
+        add("memory.available_bytes", (double)meminfo.mem_available * 1024.0);
+        double swap_used = meminfo.swap_total - meminfo.swap_free;
+        add("swap.used_percent", meminfo.swap_total > 0 ? swap_used * 100.0 / meminfo.swap_total : 0.0);
+        add("swap.total_bytes", (double)meminfo.swap_total * 1024.0);
+        add("swap.used_bytes", swap_used * 1024.0);
+    }
+    
+    pressure.sample();
+    static const char* PSI_SERIES[PSI_RESOURCE_COUNT][2] = {
+        {"psi.cpu.some", "psi.cpu.full"},
+        {"psi.memory.some", "psi.memory.full"},
+        {"psi.io.some", "psi.io.full"},
+    };
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (!primed || !pressure.available((PsiResource)i)) continue;
+        add(PSI_SERIES[i][0], pressure.some_percent[i]);
+        if (pressure.stats[i].has_full) add(PSI_SERIES[i][1], pressure.full_percent[i]);
+    }
+    
+    disks.sample();
+    if (primed) {
+        for (int i = 0; i < disks.deviceCount(); i++) {
+            add("disk", disks.names[i], "read_bytes_per_sec", disks.read_bytes_per_sec[i]);
+            add("disk", disks.names[i], "write_bytes_per_sec", disks.write_bytes_per_sec[i]);
+            add("disk", disks.names[i], "read_await_ms", disks.read_await_ms[i]);
+            add("disk", disks.names[i], "write_await_ms", disks.write_await_ms[i]);
+            add("disk", disks.names[i], "utilization", disks.utilization[i]);
+            add("disk", disks.names[i], "read_bytes_total", disks.sectors_read[i] * 512.0);
+            add("disk", disks.names[i], "written_bytes_total", disks.sectors_written[i] * 512.0);
+        }
+    }
+    
+    samples++;
+    for (const auto& stats : getAllNetworkStats()) {
+        InterfaceBytes current = {stats.rx_bytes, stats.tx_bytes, samples};
+        auto found = interfaces.find(stats.interface_name);
+        if (found == interfaces.end()) {
+            interfaces.emplace(stats.interface_name, current);
+            continue;
+        }
+        if (primed && elapsed > 0.0) {
+            // Counters that went backwards were reset (interface re-created)
+            double rx = current.rx >= found->second.rx ? (current.rx - found->second.rx) / elapsed : 0.0;
+            double tx = current.tx >= found->second.tx ? (current.tx - found->second.tx) / elapsed : 0.0;
+            add("net", stats.interface_name, "rx_bytes_per_sec", rx);
+            add("net", stats.interface_name, "tx_bytes_per_sec", tx);
+            add("net", stats.interface_name, "rx_bytes_total", current.rx);
+            add("net", stats.interface_name, "tx_bytes_total", current.tx);
+        }
+        found->second = current;
+    }
+    for (auto it = interfaces.begin(); it != interfaces.end();) {
+        if (it->second.seen != samples) it = interfaces.erase(it);
+        else ++it;
+    }
+    
+    bool was_primed = primed;
+    primed = true;
+    last_time = now;
+    if (!was_primed) return;
+    
+    // Keep the shared names unless the layout changed
+    if (names->size() != pending_count || !equal(names->begin(), names->end(), pending_names.begin())) {
+        names = make_shared<vector<string>>(pending_names.begin(), pending_names.begin() + pending_count);
+    }
+    
+    auto next = make_shared<SystemSample>();
+    next->time = chrono::duration<double>(now.time_since_epoch()).count();
+    next->wall_time = chrono::duration<double>(chrono::system_clock::now().time_since_epoch()).count();
+    next->names = names;
+    next->values.assign(pending_values.begin(), pending_values.begin() + pending_count);
+    {
+        lock_guard<mutex> guard(lock);
+        next->generation = ++generation;
+        published = next;
+    }
+    
+    for (auto& hook : hooks) {
+        hook(*next);
+    }
+}